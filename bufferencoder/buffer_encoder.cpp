@@ -390,7 +390,7 @@ GstFlowReturn BufferEncoder::OnEncodedBuffer(GstElement *elt, gpointer *data)
 
         if (!map_info.data || map_info.size == 0)
         {
-            PLOGD(": Empty buffer received");
+            PLOGD_EVERY_MS(1000, ": Empty buffer received");
             gst_buffer_unmap(buffer, &map_info);
             gst_sample_unref(sample);
             return GST_FLOW_OK;
@@ -419,7 +419,7 @@ GstFlowReturn BufferEncoder::OnEncodedBuffer(GstElement *elt, gpointer *data)
         }
 
         uint64_t timestamp = GST_BUFFER_TIMESTAMP(buffer);
-        PLOGD("OnEncodedBuffer: Buffer ready, calling MCIL::GstVideoEncoder. --#");
+        PLOGD_EVERY_N(100, "OnEncodedBuffer: Buffer ready, calling MCIL::GstVideoEncoder. --#");
         encoder->buffer_callback_(map_info.data, map_info.size, timestamp, is_keyframe);
 
         gst_buffer_unmap(buffer, &map_info);
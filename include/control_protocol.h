@@ -0,0 +1,138 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/**
+ * Control channel between the service and a g-record-pipeline process.
+ * A SOCK_SEQPACKET socketpair, one end inherited by the pipeline at spawn time.
+ * Every message is a header_t followed by length bytes of payload, sent as one packet.
+ * Both ends are built together and run on the same host, so the layout is native.
+ */
+namespace control
+{
+
+// largest payload, the configuration of start and the statistics are the big ones
+const uint32_t kMaxPayload = 128 * 1024;
+
+enum type_t : uint16_t
+{
+    REQUEST = 1,
+    REPLY,
+    NOTIFY,
+};
+
+enum command_t : uint16_t
+{
+    CMD_START = 1,         // payload: configuration json
+    CMD_STOP,              // replies once capture has stopped
+    CMD_PAUSE,
+    CMD_RESUME,
+    CMD_GET_STATISTICS,    // reply payload: statistics json
+    CMD_REQUEST_KEY_FRAME,
+};
+
+enum event_t : uint16_t
+{
+    EVT_RECORDING_STATUS = 1, // payload: recording_status_t
+    EVT_FINALIZED,            // payload: finalized_t then the path
+    EVT_END_OF_STREAM,
+    EVT_ERROR,                // result: error code, payload: error text
+    EVT_LOAD_COMPLETED,
+    EVT_UNLOAD_COMPLETED,
+    EVT_PLAYING,
+    EVT_PAUSED,
+    EVT_JSON,                 // payload: any other notification as json
+};
+
+struct header_t
+{
+    uint16_t type;   // type_t
+    uint16_t code;   // command_t, or event_t of a notification
+    uint32_t seq;    // of the request, repeated by its reply
+    int32_t result;  // of a reply, 0 on success
+    uint32_t length; // bytes of payload following the header
+};
+
+struct recording_status_t
+{
+    uint64_t duration; // ns of media recorded
+    uint64_t bytes;    // bytes written to the sink
+    uint64_t bitrate;  // bps over the last interval
+    double fps;        // encoded frames per second over the last interval
+    uint64_t frames;   // encoded video frames
+    uint64_t dropped;  // frames dropped as reported by QoS
+};
+
+struct finalized_t
+{
+    uint64_t duration; // ns of media recorded
+    uint64_t size;     // bytes of the finalized file
+};
+
+// Sends one message. Returns false once the other end is gone.
+inline bool send(int fd, const header_t &header, const void *payload = nullptr)
+{
+    struct iovec iov[2] = {{const_cast<header_t *>(&header), sizeof(header)},
+                           {const_cast<void *>(payload), header.length}};
+    struct msghdr msg   = {};
+    msg.msg_iov         = iov;
+    msg.msg_iovlen      = (header.length > 0) ? 2 : 1;
+
+    ssize_t ret;
+    do
+        ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    while (ret < 0 && errno == EINTR);
+
+    return ret == (ssize_t)(sizeof(header) + header.length);
+}
+
+// Receives one message into header and payload, blocking unless the socket is not.
+// Returns false on end of stream or a malformed message.
+inline bool receive(int fd, header_t &header, std::string &payload)
+{
+    // the header tells the size of the packet, so that the payload is read into place
+    ssize_t ret;
+    do
+        ret = recv(fd, &header, sizeof(header), MSG_PEEK);
+    while (ret < 0 && errno == EINTR);
+
+    if (ret != (ssize_t)sizeof(header) || header.length > kMaxPayload)
+    {
+        payload.clear();
+        return false;
+    }
+
+    payload.resize(header.length);
+    struct iovec iov[2] = {{&header, sizeof(header)}, {&payload[0], payload.size()}};
+    struct msghdr msg   = {};
+    msg.msg_iov         = iov;
+    msg.msg_iovlen      = (header.length > 0) ? 2 : 1;
+
+    do
+        ret = recvmsg(fd, &msg, 0);
+    while (ret < 0 && errno == EINTR);
+
+    return ret == (ssize_t)(sizeof(header) + header.length) && !(msg.msg_flags & MSG_TRUNC);
+}
+
+} // namespace control
@@ -0,0 +1,24 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+/**
+ * CPU time each audio encoder took for the same test audio, measured by record_benchmark -e
+ * on the device and read by g-record-pipeline to pick the cheapest AAC encoder on load.
+ * {"<encoder>": <cpu us>}. It is kept across reboots, the installed encoders rarely change.
+ */
+const char kEncoderRankingPath[] = "/var/lib/g-record-pipeline/encoder_ranking.json";
@@ -0,0 +1,386 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * Flight recorder, an always-on ring of fixed-size binary events.
+ * The service and every g-record-pipeline process record into their own ring, mapped from
+ * shared memory at /dev/shm/mediarecorder-flight-<pid>, so that it outlives a crash.
+ * A ring is copied to kDumpDir on a pipeline error, a call timeout or a fatal signal, and
+ * decoded offline with flight_decoder. Only the newest kMaxDumps dumps are kept.
+ *
+ * record() takes a slot with one atomic increment and publishes it per record like a
+ * seqlock, without locks or allocation. Old records are overwritten once the ring is full.
+ */
+namespace flight
+{
+
+const uint32_t kMagic    = 0x4d524652; // "MRFR"
+const uint16_t kVersion  = 2;
+const uint32_t kCapacity = 8192; // records, a power of two
+const char kDumpDir[]    = "/tmp/mediarecorder-flight";
+const size_t kMaxDumps   = 8; // in kDumpDir, an error storm does not fill the disk
+
+enum event_t : uint16_t
+{
+    EV_API_CALL = 1, // text: method
+    EV_API_REPLY,    // text: method, a: ErrorCode
+    EV_COMMAND,      // text: side, a: control::command_t, b: result
+    EV_NOTIFY,       // text: side, a: control::event_t, b: result
+    EV_STATE,        // text: element, a: old GstState, b: new GstState
+    EV_BUS_MESSAGE,  // text: source, a: GstMessageType
+    EV_BUFFERS,      // a: encoded video frames, b: bytes written
+    EV_ERROR,        // text: source, a: error code
+    EV_TIMEOUT,      // text: channel, a: control::command_t
+    EV_SPAWN,        // text: program, a: pid
+    EV_EXIT,         // a: pid, b: wait status
+    EV_SIGNAL,       // a: signal number, the process is crashing
+    EV_DUMP,         // text: reason
+};
+
+struct record_t
+{
+    std::atomic<uint64_t> seq; // index + 1 of the record, 0 while it is being written
+    uint64_t time;             // CLOCK_MONOTONIC ns
+    uint64_t a;
+    uint64_t b;
+    uint32_t tid;
+    uint16_t event; // event_t
+    uint16_t reserved;
+    char text[24]; // truncated, always terminated
+};
+static_assert(sizeof(record_t) == 64, "record_t is one cache line");
+
+struct ring_t
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    int32_t pid;
+    char name[32];
+    uint64_t monotonicBase; // CLOCK_MONOTONIC ns when the ring was opened
+    uint64_t realtimeBase;  // CLOCK_REALTIME ns at the same time
+
+    // set once the fatal signal handler wrote the ring, collect() only removes it then
+    std::atomic<uint32_t> dumped;
+
+    alignas(64) std::atomic<uint64_t> head; // index of the next record
+    alignas(64) record_t records[kCapacity];
+};
+
+inline ring_t *&ring()
+{
+    static ring_t *ring = nullptr;
+    return ring;
+}
+
+inline uint64_t now(clockid_t clock = CLOCK_MONOTONIC)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Writes the decimal digits of n to out and returns their count. Async-signal-safe.
+inline size_t formatNumber(char *out, uint64_t n)
+{
+    char digits[20];
+    size_t count = 0;
+    do
+        digits[count++] = '0' + n % 10;
+    while ((n /= 10) > 0);
+
+    for (size_t i = 0; i < count; i++)
+        out[i] = digits[count - 1 - i];
+    return count;
+}
+
+inline void shmName(char (&name)[48], pid_t pid)
+{
+    const char prefix[] = "/mediarecorder-flight-";
+    size_t len          = sizeof(prefix) - 1;
+    memcpy(name, prefix, len);
+    len += formatNumber(name + len, pid);
+    name[len] = '\0';
+}
+
+inline uint32_t threadId()
+{
+    static thread_local uint32_t tid = gettid();
+    return tid;
+}
+
+inline void recordTo(ring_t *ring, uint16_t event, uint64_t a, uint64_t b, const char *text,
+                     uint32_t tid)
+{
+    uint64_t index = ring->head.fetch_add(1, std::memory_order_relaxed);
+    record_t &r    = ring->records[index & (kCapacity - 1)];
+
+    r.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    r.time  = now();
+    r.a     = a;
+    r.b     = b;
+    r.tid   = tid;
+    r.event = event;
+    size_t i = 0;
+    for (; text && text[i] && i < sizeof(r.text) - 1; i++)
+        r.text[i] = text[i];
+    r.text[i] = '\0';
+    r.seq.store(index + 1, std::memory_order_release);
+}
+
+// Records one event, nothing before open() or after close().
+inline void record(uint16_t event, uint64_t a = 0, uint64_t b = 0, const char *text = nullptr)
+{
+    ring_t *r = ring();
+    if (r)
+        recordTo(r, event, a, b, text, threadId());
+}
+
+// Numbers the dumps written by this process. Async-signal-safe.
+inline uint32_t nextDump()
+{
+    static std::atomic<uint32_t> dumps{0};
+    return dumps.fetch_add(1);
+}
+
+// Writes ring to kDumpDir/<name>-<pid>-<n>.flight. Async-signal-safe.
+inline bool writeRing(const ring_t *ring, uint32_t n)
+{
+    char path[128];
+    size_t len  = 0;
+    auto append = [&path, &len](const char *s)
+    {
+        for (; *s && len < sizeof(path) - 1; s++)
+            path[len++] = *s;
+    };
+    auto appendNumber = [&append](uint64_t number)
+    {
+        char digits[21];
+        digits[formatNumber(digits, number)] = '\0';
+        append(digits);
+    };
+    append(kDumpDir);
+    append("/");
+    append(ring->name[0] ? ring->name : "unknown");
+    append("-");
+    appendNumber(ring->pid);
+    append("-");
+    appendNumber(n);
+    append(".flight");
+    path[len] = '\0';
+
+    mkdir(kDumpDir, 0755);
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+
+    const char *data = reinterpret_cast<const char *>(ring);
+    size_t left      = sizeof(ring_t);
+    while (left > 0)
+    {
+        ssize_t ret = write(fd, data, left);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            break;
+        data += ret;
+        left -= ret;
+    }
+    ::close(fd);
+    return left == 0;
+}
+
+// Removes the oldest dumps of every process, leaving room for one more.
+inline void rotateDumps()
+{
+    DIR *dir = opendir(kDumpDir);
+    if (!dir)
+        return;
+
+    std::vector<std::pair<uint64_t, std::string>> dumps; // mtime ns, path
+    const char suffix[] = ".flight";
+    while (struct dirent *entry = readdir(dir))
+    {
+        size_t len = strlen(entry->d_name);
+        if (len < sizeof(suffix) || strcmp(entry->d_name + len - sizeof(suffix) + 1, suffix) != 0)
+            continue;
+
+        std::string path = std::string(kDumpDir) + "/" + entry->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0)
+            dumps.emplace_back((uint64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec,
+                               std::move(path));
+    }
+    closedir(dir);
+
+    if (dumps.size() < kMaxDumps)
+        return;
+    std::sort(dumps.begin(), dumps.end());
+    for (size_t i = 0; i <= dumps.size() - kMaxDumps; i++)
+        unlink(dumps[i].second.c_str());
+}
+
+// Records the dump in ring and writes it to kDumpDir, the oldest dumps beyond kMaxDumps are
+// removed first.
+inline bool dumpRing(ring_t *ring, const char *reason)
+{
+    uint32_t n = nextDump();
+    recordTo(ring, EV_DUMP, n, 0, reason, threadId());
+    rotateDumps();
+    return writeRing(ring, n);
+}
+
+// Dumps the ring of this process.
+inline bool dump(const char *reason)
+{
+    ring_t *r = ring();
+    return r && dumpRing(r, reason);
+}
+
+// Only records and writes the ring, then exits, nothing of it needs to be async-signal-safe
+// otherwise. The shared memory is left to collect() of the service, and rotateDumps() to
+// the next dump.
+inline void crashHandler(int signal)
+{
+    ring_t *r = ring();
+    if (r)
+    {
+        uint32_t n = nextDump();
+        recordTo(r, EV_SIGNAL, signal, 0, nullptr, gettid());
+        recordTo(r, EV_DUMP, n, 0, "signal", gettid());
+        if (writeRing(r, n))
+            r->dumped.store(1, std::memory_order_release);
+    }
+    _exit(128 + signal);
+}
+
+// Maps the ring of this process and dumps it on a fatal signal. name tells the process in
+// the dump, e.g. "service".
+inline bool open(const char *name)
+{
+    if (ring())
+        return true;
+
+    char shm[48];
+    shmName(shm, getpid());
+    int fd = shm_open(shm, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, sizeof(ring_t)) == 0)
+        addr = mmap(nullptr, sizeof(ring_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        shm_unlink(shm);
+        return false;
+    }
+
+    // fresh pages are zero, every record is empty
+    auto *r          = static_cast<ring_t *>(addr);
+    r->magic         = kMagic;
+    r->version       = kVersion;
+    r->recordSize    = sizeof(record_t);
+    r->capacity      = kCapacity;
+    r->pid           = getpid();
+    r->monotonicBase = now(CLOCK_MONOTONIC);
+    r->realtimeBase  = now(CLOCK_REALTIME);
+    strncpy(r->name, name, sizeof(r->name) - 1);
+    ring() = r;
+
+    struct sigaction action = {};
+    action.sa_handler       = crashHandler;
+    action.sa_flags         = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    const int signals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+    for (int signal : signals)
+        sigaction(signal, &action, nullptr);
+
+    return true;
+}
+
+// Unmaps and removes the ring on a normal exit.
+inline void close()
+{
+    ring_t *r = ring();
+    if (!r)
+        return;
+    ring() = nullptr;
+
+    char shm[48];
+    shmName(shm, r->pid);
+    munmap(r, sizeof(ring_t));
+    shm_unlink(shm);
+}
+
+// Opens the ring for the lifetime of main(), so that every return path closes it.
+struct scope_t
+{
+    explicit scope_t(const char *name) { open(name); }
+    ~scope_t() { close(); }
+
+    scope_t(const scope_t &)            = delete;
+    scope_t &operator=(const scope_t &) = delete;
+};
+
+// Dumps and removes the ring a dead process left behind, if any.
+inline bool collect(pid_t pid, const char *reason)
+{
+    char shm[48];
+    shmName(shm, pid);
+    int fd = shm_open(shm, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size == (off_t)sizeof(ring_t))
+        addr = mmap(nullptr, sizeof(ring_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    shm_unlink(shm);
+    if (addr == MAP_FAILED)
+        return false;
+
+    // a ring its fatal signal handler wrote is only removed
+    auto *r     = static_cast<ring_t *>(addr);
+    bool result = r->magic == kMagic && r->version == kVersion &&
+                  (r->dumped.load(std::memory_order_acquire) || dumpRing(r, reason));
+    munmap(addr, sizeof(ring_t));
+    return result;
+}
+
+} // namespace flight
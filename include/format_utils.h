@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 struct stream_format_t
@@ -31,6 +32,10 @@ struct video_format_t : stream_format_t
     unsigned int height  = 0;
     unsigned int fps     = 0;
     unsigned int bitRate = 0;
+
+    // lower bounds for the adaptive rate controller, 0 keeps the value fixed
+    unsigned int minBitRate = 0;
+    unsigned int minFps     = 0;
 };
 
 struct audio_format_t : stream_format_t
@@ -18,6 +18,7 @@
 #define MEDIARECORDER_SERVICE_LOG_MESSAGES_H_
 
 #include "PmLogLib.h"
+#include "log_rate.h"
 
 static inline PmLogContext getRecorderLunaPmLogContext()
 {
@@ -38,13 +39,50 @@ static inline PmLogContext getRecorderLunaPmLogContext()
 #define LOG_TAG "MediaRecorder"
 #endif
 
+/*
+ * Least severe level compiled in, as a PmLogLevel. Calls below it compile to nothing,
+ * e.g. -DPLOG_MIN_LEVEL=kPmLogLevel_Info leaves the PLOGD calls out.
+ */
+#ifndef PLOG_MIN_LEVEL
+#define PLOG_MIN_LEVEL kPmLogLevel_Debug
+#endif
+
+/*
+ * Whether LEVEL__ is logged. The macros below check it before their arguments, the
+ * prefix included, are evaluated.
+ */
+#define PLOG_ENABLED(LEVEL__)                                                                      \
+    ((LEVEL__) <= PLOG_MIN_LEVEL && PmLogIsEnabled(getRecorderLunaPmLogContext(), LEVEL__))
+
+#define PLOGI_(FORMAT__, ...)                                                                      \
+    PmLogInfo(getRecorderLunaPmLogContext(), LOG_TAG, 0, "[%d:%d][%s():%d] " FORMAT__, getpid(),   \
+              gettid(), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define PLOGW_(FORMAT__, ...)                                                                      \
+    PmLogWarning(getRecorderLunaPmLogContext(), LOG_TAG, 0, "[%d:%d][%s():%d] " FORMAT__,          \
+                 getpid(), gettid(), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define PLOGE_(FORMAT__, ...)                                                                      \
+    PmLogError(getRecorderLunaPmLogContext(), LOG_TAG, 0, "[%d:%d][%s():%d] " FORMAT__, getpid(),  \
+               gettid(), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define PLOGD_(FORMAT__, ...)                                                                      \
+    PmLogDebug(getRecorderLunaPmLogContext(), "[%d:%d][%s():%d] " FORMAT__, getpid(), gettid(),    \
+               __FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define PLOG_IF_(COND__, LOG__, FORMAT__, ...)                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        if (COND__)                                                                                \
+            LOG__(FORMAT__, ##__VA_ARGS__);                                                        \
+    } while (0)
+
 /*
  * Simplified macro to send a info log message using the current LOG_TAG.
  */
 #ifndef PLOGI
 #define PLOGI(FORMAT__, ...)                                                                       \
-    PmLogInfo(getRecorderLunaPmLogContext(), LOG_TAG, 0, "[%d:%d][%s():%d] " FORMAT__, getpid(),   \
-              gettid(), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+    PLOG_IF_(PLOG_ENABLED(kPmLogLevel_Info), PLOGI_, FORMAT__, ##__VA_ARGS__)
 #endif
 
 /*
@@ -52,8 +90,7 @@ static inline PmLogContext getRecorderLunaPmLogContext()
  */
 #ifndef PLOGW
 #define PLOGW(FORMAT__, ...)                                                                       \
-    PmLogWarning(getRecorderLunaPmLogContext(), LOG_TAG, 0, "[%d:%d][%s():%d] " FORMAT__,          \
-                 getpid(), gettid(), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+    PLOG_IF_(PLOG_ENABLED(kPmLogLevel_Warning), PLOGW_, FORMAT__, ##__VA_ARGS__)
 #endif
 
 /*
@@ -61,8 +98,7 @@ static inline PmLogContext getRecorderLunaPmLogContext()
  */
 #ifndef PLOGE
 #define PLOGE(FORMAT__, ...)                                                                       \
-    PmLogError(getRecorderLunaPmLogContext(), LOG_TAG, 0, "[%d:%d][%s():%d] " FORMAT__, getpid(),  \
-               gettid(), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+    PLOG_IF_(PLOG_ENABLED(kPmLogLevel_Error), PLOGE_, FORMAT__, ##__VA_ARGS__)
 #endif
 
 /*
@@ -70,8 +106,42 @@ static inline PmLogContext getRecorderLunaPmLogContext()
  */
 #ifndef PLOGD
 #define PLOGD(FORMAT__, ...)                                                                       \
-    PmLogDebug(getRecorderLunaPmLogContext(), "[%d:%d][%s():%d] " FORMAT__, getpid(), gettid(),    \
-               __FUNCTION__, __LINE__, ##__VA_ARGS__)
+    PLOG_IF_(PLOG_ENABLED(kPmLogLevel_Debug), PLOGD_, FORMAT__, ##__VA_ARGS__)
 #endif
 
+/*
+ * Rate-limited variants for per-frame sites: the first call of the site is logged, then
+ * at most one call every PERIOD_MS__ ms.
+ */
+#define PLOG_EVERY_MS_(LEVEL__, LOG__, PERIOD_MS__, FORMAT__, ...)                                 \
+    do                                                                                             \
+    {                                                                                              \
+        static std::atomic<int64_t> plogNext_{0};                                                  \
+        if (PLOG_ENABLED(LEVEL__) && log_rate::every(plogNext_, PERIOD_MS__))                      \
+            LOG__(FORMAT__, ##__VA_ARGS__);                                                        \
+    } while (0)
+
+#define PLOGI_EVERY_MS(PERIOD_MS__, FORMAT__, ...)                                                 \
+    PLOG_EVERY_MS_(kPmLogLevel_Info, PLOGI_, PERIOD_MS__, FORMAT__, ##__VA_ARGS__)
+#define PLOGW_EVERY_MS(PERIOD_MS__, FORMAT__, ...)                                                 \
+    PLOG_EVERY_MS_(kPmLogLevel_Warning, PLOGW_, PERIOD_MS__, FORMAT__, ##__VA_ARGS__)
+#define PLOGD_EVERY_MS(PERIOD_MS__, FORMAT__, ...)                                                 \
+    PLOG_EVERY_MS_(kPmLogLevel_Debug, PLOGD_, PERIOD_MS__, FORMAT__, ##__VA_ARGS__)
+
+/*
+ * Sampled variants: the 1st, N__+1th, 2*N__+1th, ... call of the site is logged.
+ */
+#define PLOG_EVERY_N_(LEVEL__, LOG__, N__, FORMAT__, ...)                                          \
+    do                                                                                             \
+    {                                                                                              \
+        static std::atomic<uint32_t> plogCount_{0};                                                \
+        if (PLOG_ENABLED(LEVEL__) && log_rate::sample(plogCount_, N__))                            \
+            LOG__(FORMAT__, ##__VA_ARGS__);                                                        \
+    } while (0)
+
+#define PLOGI_EVERY_N(N__, FORMAT__, ...)                                                          \
+    PLOG_EVERY_N_(kPmLogLevel_Info, PLOGI_, N__, FORMAT__, ##__VA_ARGS__)
+#define PLOGD_EVERY_N(N__, FORMAT__, ...)                                                          \
+    PLOG_EVERY_N_(kPmLogLevel_Debug, PLOGD_, N__, FORMAT__, ##__VA_ARGS__)
+
 #endif /* MEDIARECORDER_SERVICE_LOG_MESSAGES_H_ */
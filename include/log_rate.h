@@ -0,0 +1,52 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <time.h>
+
+/**
+ * Per call site state of the rate-limited and sampled log macros of log.h and glog.h.
+ * Both are lock-free, so that they can be used on streaming threads.
+ */
+namespace log_rate
+{
+
+// True for the first call, then at most once every periodMs. next is the time of the
+// next call let through.
+inline bool every(std::atomic<int64_t> &next, int64_t periodMs)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    int64_t now = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    int64_t expected = next.load(std::memory_order_relaxed);
+    if (now < expected)
+        return false;
+
+    // one of the threads racing for the same slot wins
+    return next.compare_exchange_strong(expected, now + periodMs, std::memory_order_relaxed);
+}
+
+// True for the 1st, n+1th, 2n+1th, ... call.
+inline bool sample(std::atomic<uint32_t> &count, uint32_t n)
+{
+    return count.fetch_add(1, std::memory_order_relaxed) % n == 0;
+}
+
+} // namespace log_rate
@@ -104,6 +104,73 @@ struct load_param_t
     std::string uri;
 };
 
+struct recording_status_t
+{
+    uint64_t duration; // ns of media recorded
+    uint64_t bytes;    // bytes written to the sink
+    uint64_t bitrate;  // bps over the last interval
+    double fps;        // encoded frames per second over the last interval
+    uint64_t frames;   // encoded video frames
+    uint64_t dropped;  // frames dropped as reported by QoS
+};
+
+struct finalized_t
+{
+    std::string path;
+    uint64_t duration; // ns of media recorded
+    uint64_t size;     // bytes of the finalized file
+};
+
+struct element_stats_t
+{
+    std::string name;
+    uint64_t buffers_in;
+    uint64_t buffers_out;
+    uint64_t dropped;
+    uint64_t latency_avg; // ns
+    uint64_t latency_max; // ns
+    std::vector<uint64_t> latency_histogram; // [i] : latency < 2^i us, last one unbounded
+    uint64_t cpu_time;                       // ns, streaming threads driven by this element
+};
+
+struct rate_adaptation_t
+{
+    uint64_t time;      // ns since the rate controller was started
+    std::string reason; // "qos", "encoder", "sink" or "recovered"
+    uint32_t bitrate;   // bps applied to the encoder, 0 if left to the encoder
+    uint32_t fps;       // frames per second let into the encoder
+};
+
+struct timing_event_t
+{
+    std::string stage;
+    uint64_t start; // us since the process was started
+    uint64_t end;   // us since the process was started
+};
+
+struct startup_timing_t
+{
+    std::vector<timing_event_t> events;
+};
+
+struct audio_stats_t
+{
+    std::string source;      // capture element
+    std::string encoder;     // encoder element
+    uint64_t duration;       // ns of audio encoded
+    uint64_t cpu_time;       // ns, capture and encoding threads
+    uint64_t cpu_per_minute; // ns of cpu time per minute of audio
+};
+
+struct pipeline_stats_t
+{
+    bool enabled;
+    uint64_t elapsed; // ns since the tracer was enabled
+    std::vector<element_stats_t> elements;
+    std::vector<rate_adaptation_t> adaptations;
+    audio_stats_t audio;
+};
+
 } // namespace base
 
 #endif // SRC_BASE_BASE_H_
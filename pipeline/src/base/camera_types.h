@@ -60,6 +60,10 @@ typedef enum
     GRP_NOTIFY_VIDEO_INFO,
     GRP_NOTIFY_ACTIVITY,
     GRP_NOTIFY_ACQUIRE_RESOURCE,
+    GRP_NOTIFY_RECORDING_STATUS,
+    GRP_NOTIFY_STARTUP_TIMING,
+    GRP_NOTIFY_FINALIZED,
+    GRP_NOTIFY_RELEASE_RESOURCE,
     GRP_NOTIFY_MAX
 } GRP_NOTIFY_TYPE_T;
 
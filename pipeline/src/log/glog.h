@@ -19,25 +19,81 @@
 
 #include <PmLogLib.h>
 #include <assert.h>
+#include "log_rate.h"
 
 PmLogContext GetPmLogContext();
 
-#define LOGI(FORMAT__, ...)                                                                        \
+/*
+ * Least severe level compiled in, as a PmLogLevel. Calls below it compile to nothing,
+ * e.g. -DLOG_MIN_LEVEL=kPmLogLevel_Info leaves the LOGD calls out.
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL kPmLogLevel_Debug
+#endif
+
+/* Checked before the arguments, __PRETTY_FUNCTION__ and the ids included, are evaluated */
+#define LOG_ENABLED(LEVEL__)                                                                       \
+    ((LEVEL__) <= LOG_MIN_LEVEL && PmLogIsEnabled(GetPmLogContext(), LEVEL__))
+
+#define LOGI_(FORMAT__, ...)                                                                       \
     PmLogInfo(GetPmLogContext(), "grp", 0, "[%d:%d][%s:%d] " FORMAT__, getpid(), gettid(),         \
               __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
 
-#define LOGD(FORMAT__, ...)                                                                        \
+#define LOGD_(FORMAT__, ...)                                                                       \
     PmLogDebug(GetPmLogContext(), "[%d:%d][%s:%d]" FORMAT__, getpid(), gettid(),                   \
                __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
 
-#define LOGE(FORMAT__, ...)                                                                        \
+#define LOGE_(FORMAT__, ...)                                                                       \
     PmLogError(GetPmLogContext(), "grp", 0, "[%d:%d][%s:%d] " FORMAT__, getpid(), gettid(),        \
                __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
 
-#define LOGW(FORMAT__, ...)                                                                        \
+#define LOGW_(FORMAT__, ...)                                                                       \
     PmLogWarning(GetPmLogContext(), "grp", 0, "[%d:%d][%s:%d] " FORMAT__, getpid(), gettid(),      \
                  __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
 
+#define LOG_IF_(COND__, LOG__, FORMAT__, ...)                                                      \
+    do                                                                                             \
+    {                                                                                              \
+        if (COND__)                                                                                \
+            LOG__(FORMAT__, ##__VA_ARGS__);                                                        \
+    } while (0)
+
+#define LOGI(FORMAT__, ...) LOG_IF_(LOG_ENABLED(kPmLogLevel_Info), LOGI_, FORMAT__, ##__VA_ARGS__)
+#define LOGD(FORMAT__, ...) LOG_IF_(LOG_ENABLED(kPmLogLevel_Debug), LOGD_, FORMAT__, ##__VA_ARGS__)
+#define LOGE(FORMAT__, ...) LOG_IF_(LOG_ENABLED(kPmLogLevel_Error), LOGE_, FORMAT__, ##__VA_ARGS__)
+#define LOGW(FORMAT__, ...)                                                                        \
+    LOG_IF_(LOG_ENABLED(kPmLogLevel_Warning), LOGW_, FORMAT__, ##__VA_ARGS__)
+
+/* Rate-limited: the first call of the site, then at most one every PERIOD_MS__ ms */
+#define LOG_EVERY_MS_(LEVEL__, LOG__, PERIOD_MS__, FORMAT__, ...)                                  \
+    do                                                                                             \
+    {                                                                                              \
+        static std::atomic<int64_t> logNext_{0};                                                   \
+        if (LOG_ENABLED(LEVEL__) && log_rate::every(logNext_, PERIOD_MS__))                        \
+            LOG__(FORMAT__, ##__VA_ARGS__);                                                        \
+    } while (0)
+
+#define LOGI_EVERY_MS(PERIOD_MS__, FORMAT__, ...)                                                  \
+    LOG_EVERY_MS_(kPmLogLevel_Info, LOGI_, PERIOD_MS__, FORMAT__, ##__VA_ARGS__)
+#define LOGW_EVERY_MS(PERIOD_MS__, FORMAT__, ...)                                                  \
+    LOG_EVERY_MS_(kPmLogLevel_Warning, LOGW_, PERIOD_MS__, FORMAT__, ##__VA_ARGS__)
+#define LOGD_EVERY_MS(PERIOD_MS__, FORMAT__, ...)                                                  \
+    LOG_EVERY_MS_(kPmLogLevel_Debug, LOGD_, PERIOD_MS__, FORMAT__, ##__VA_ARGS__)
+
+/* Sampled: the 1st, N__+1th, 2*N__+1th, ... call of the site */
+#define LOG_EVERY_N_(LEVEL__, LOG__, N__, FORMAT__, ...)                                           \
+    do                                                                                             \
+    {                                                                                              \
+        static std::atomic<uint32_t> logCount_{0};                                                 \
+        if (LOG_ENABLED(LEVEL__) && log_rate::sample(logCount_, N__))                              \
+            LOG__(FORMAT__, ##__VA_ARGS__);                                                        \
+    } while (0)
+
+#define LOGI_EVERY_N(N__, FORMAT__, ...)                                                           \
+    LOG_EVERY_N_(kPmLogLevel_Info, LOGI_, N__, FORMAT__, ##__VA_ARGS__)
+#define LOGD_EVERY_N(N__, FORMAT__, ...)                                                           \
+    LOG_EVERY_N_(kPmLogLevel_Debug, LOGD_, N__, FORMAT__, ##__VA_ARGS__)
+
 /* Assert print */
 #define GRPASSERT(cond)                                                                            \
     {                                                                                              \
@@ -16,78 +16,411 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "serializer.h"
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 
 namespace parser
 {
 
+void JsonWriter::clear()
+{
+    _buffer.clear();
+    _first.clear();
+    _afterKey = false;
+}
+
+void JsonWriter::separate()
+{
+    if (_afterKey)
+    {
+        _afterKey = false;
+        return;
+    }
+    if (_first.empty())
+        return;
+
+    if (_first.back())
+        _first.back() = false;
+    else
+        _buffer += ',';
+}
+
+void JsonWriter::beginObject()
+{
+    separate();
+    _buffer += '{';
+    _first.push_back(true);
+}
+
+void JsonWriter::endObject()
+{
+    _buffer += '}';
+    _first.pop_back();
+}
+
+void JsonWriter::beginArray()
+{
+    separate();
+    _buffer += '[';
+    _first.push_back(true);
+}
+
+void JsonWriter::endArray()
+{
+    _buffer += ']';
+    _first.pop_back();
+}
+
+void JsonWriter::key(const char *key)
+{
+    separate();
+    string(key, strlen(key));
+    _buffer += ':';
+    _afterKey = true;
+}
+
+void JsonWriter::value(bool value)
+{
+    separate();
+    _buffer += value ? "true" : "false";
+}
+
+void JsonWriter::value(int32_t value) { this->value((int64_t)value); }
+
+void JsonWriter::value(uint32_t value) { this->value((uint64_t)value); }
+
+void JsonWriter::value(int64_t value)
+{
+    separate();
+    char number[24];
+    int length = snprintf(number, sizeof(number), "%" PRId64, value);
+    _buffer.append(number, length);
+}
+
+void JsonWriter::value(uint64_t value)
+{
+    separate();
+    char number[24];
+    int length = snprintf(number, sizeof(number), "%" PRIu64, value);
+    _buffer.append(number, length);
+}
+
+void JsonWriter::value(double value)
+{
+    separate();
+    if (!std::isfinite(value))
+    {
+        _buffer += "null";
+        return;
+    }
+    char number[32];
+    int length = snprintf(number, sizeof(number), "%.15g", value);
+    _buffer.append(number, length);
+}
+
+void JsonWriter::value(const char *value)
+{
+    separate();
+    string(value, strlen(value));
+}
+
+void JsonWriter::value(const std::string &value)
+{
+    separate();
+    string(value.data(), value.size());
+}
+
+void JsonWriter::string(const char *value, size_t length)
+{
+    _buffer += '"';
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = value[i];
+        switch (c)
+        {
+        case '"':
+            _buffer += "\\\"";
+            break;
+        case '\\':
+            _buffer += "\\\\";
+            break;
+        case '\n':
+            _buffer += "\\n";
+            break;
+        case '\r':
+            _buffer += "\\r";
+            break;
+        case '\t':
+            _buffer += "\\t";
+            break;
+        default:
+            if (c < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                _buffer += escaped;
+            }
+            else
+            {
+                _buffer += (char)c;
+            }
+            break;
+        }
+    }
+    _buffer += '"';
+}
+
 template <>
-pbnjson::JValue to_json(const base::result_t &result)
+void to_json(JsonWriter &writer, const base::result_t &result)
 {
-    return pbnjson::JObject{{"state", result.state}, {"mediaId", result.mediaId}};
+    writer.beginObject();
+    writer.key("state");
+    writer.value(result.state);
+    writer.key("mediaId");
+    writer.value(result.mediaId);
+    writer.endObject();
 }
 
 template <>
-pbnjson::JValue to_json(const base::video_info_t &info)
+void to_json(JsonWriter &writer, const base::video_info_t &info)
 {
-    return pbnjson::JObject{
-        {"video",
-         pbnjson::JObject{{"codec", info.codec},
-                          {"bitrate", (int64_t)info.bit_rate},
-                          {"width", (int32_t)info.width},
-                          {"height", (int32_t)info.height},
-                          {"frame_rate", pbnjson::JObject{{"num", info.frame_rate.num},
-                                                          {"den", info.frame_rate.den}}}}}};
+    writer.beginObject();
+    writer.key("video");
+    writer.beginObject();
+    writer.key("codec");
+    writer.value(info.codec);
+    writer.key("bitrate");
+    writer.value(info.bit_rate);
+    writer.key("width");
+    writer.value(info.width);
+    writer.key("height");
+    writer.value(info.height);
+    writer.key("frame_rate");
+    writer.beginObject();
+    writer.key("num");
+    writer.value(info.frame_rate.num);
+    writer.key("den");
+    writer.value(info.frame_rate.den);
+    writer.endObject();
+    writer.endObject();
+    writer.endObject();
 }
 
 template <>
-pbnjson::JValue to_json(const base::source_info_t &info)
+void to_json(JsonWriter &writer, const base::source_info_t &info)
 {
-    pbnjson::JArray programs;
+    writer.beginObject();
+    writer.key("container");
+    writer.value(info.container);
+    writer.key("programs");
+    writer.beginArray();
     for (const auto &program : info.programs)
-        programs.put(programs.arraySize(),
-                     pbnjson::JObject{{"video_stream", (int32_t)program.video_stream}});
-    pbnjson::JArray video_streams;
-    for (const auto &video_stream : info.video_streams)
-        video_streams.put(video_streams.arraySize(), to_json(video_stream));
-
-    return pbnjson::JObject{
-        {"container", info.container}, {"programs", programs}, {"video_streams", video_streams}};
+    {
+        writer.beginObject();
+        writer.key("video_stream");
+        writer.value(program.video_stream);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.key("video_streams");
+    to_json(writer, info.video_streams);
+    writer.endObject();
 }
 
 template <>
-pbnjson::JValue to_json(const base::error_t &error)
+void to_json(JsonWriter &writer, const base::error_t &error)
 {
-    return pbnjson::JObject{
-        {"errorCode", error.errorCode}, {"errorText", error.errorText}, {"mediaId", error.mediaId}};
+    writer.beginObject();
+    writer.key("errorCode");
+    writer.value(error.errorCode);
+    writer.key("errorText");
+    writer.value(error.errorText);
+    writer.key("mediaId");
+    writer.value(error.mediaId);
+    writer.endObject();
 }
 
 template <>
-pbnjson::JValue to_json(const base::media_info_t &info)
+void to_json(JsonWriter &writer, const base::media_info_t &info)
 {
-    return pbnjson::JObject{{"mediaId", info.mediaId}};
+    writer.beginObject();
+    writer.key("mediaId");
+    writer.value(info.mediaId);
+    writer.endObject();
 }
 
 // {"options":{"option":{"windowId":"_Window_Id_1","useSeekableRanges":true,"videoDisplayMode":"Textured","appId":"com.webos.app.mediaevents-test","needAudio":true,"bufferControl":{"userBufferCtrl":false},"transmission":{"httpHeader":{"referer":"https://www.w3.org/2010/05/video/mediaevents.html","userAgent":"Mozilla/5.0
 // (Web0S; Linux) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/72.0.3626.121 Safari/537.36
 // WebAppManager","cookies":""}},"preload":"false"}},"id":"_dPG8v3e9kM98mI","uri":"https://media.w3.org/2010/05/sintel/trailer.mp4"}
 template <>
-pbnjson::JValue to_json(const base::load_param_t &load_param)
+void to_json(JsonWriter &writer, const base::load_param_t &load_param)
+{
+    writer.beginObject();
+    writer.key("options");
+    writer.beginObject();
+    writer.key("option");
+    writer.beginObject();
+    writer.key("videoDisplayMode");
+    writer.value(load_param.videoDisplayMode);
+    writer.key("display-path");
+    writer.value(load_param.displayPath);
+    writer.key("windowId");
+    writer.value(load_param.windowId);
+    writer.endObject();
+    writer.endObject();
+    writer.key("uri");
+    writer.value(load_param.uri);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::recording_status_t &status)
+{
+    writer.beginObject();
+    writer.key("duration");
+    writer.value(status.duration);
+    writer.key("bytes");
+    writer.value(status.bytes);
+    writer.key("bitrate");
+    writer.value(status.bitrate);
+    writer.key("fps");
+    writer.value(status.fps);
+    writer.key("frames");
+    writer.value(status.frames);
+    writer.key("dropped");
+    writer.value(status.dropped);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::finalized_t &finalized)
+{
+    writer.beginObject();
+    writer.key("path");
+    writer.value(finalized.path);
+    writer.key("duration");
+    writer.value(finalized.duration);
+    writer.key("size");
+    writer.value(finalized.size);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::element_stats_t &stats)
+{
+    writer.beginObject();
+    writer.key("name");
+    writer.value(stats.name);
+    writer.key("buffersIn");
+    writer.value(stats.buffers_in);
+    writer.key("buffersOut");
+    writer.value(stats.buffers_out);
+    writer.key("dropped");
+    writer.value(stats.dropped);
+    writer.key("latencyAvg");
+    writer.value(stats.latency_avg);
+    writer.key("latencyMax");
+    writer.value(stats.latency_max);
+    writer.key("latencyHistogram");
+    to_json(writer, stats.latency_histogram);
+    writer.key("cpuTime");
+    writer.value(stats.cpu_time);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::rate_adaptation_t &adaptation)
+{
+    writer.beginObject();
+    writer.key("time");
+    writer.value(adaptation.time);
+    writer.key("reason");
+    writer.value(adaptation.reason);
+    writer.key("bitRate");
+    writer.value(adaptation.bitrate);
+    writer.key("fps");
+    writer.value(adaptation.fps);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::audio_stats_t &audio)
+{
+    writer.beginObject();
+    writer.key("source");
+    writer.value(audio.source);
+    writer.key("encoder");
+    writer.value(audio.encoder);
+    writer.key("duration");
+    writer.value(audio.duration);
+    writer.key("cpuTime");
+    writer.value(audio.cpu_time);
+    writer.key("cpuPerMinute");
+    writer.value(audio.cpu_per_minute);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::pipeline_stats_t &stats)
+{
+    writer.beginObject();
+    writer.key("enabled");
+    writer.value(stats.enabled);
+    writer.key("elapsed");
+    writer.value(stats.elapsed);
+    writer.key("elements");
+    to_json(writer, stats.elements);
+    writer.key("adaptations");
+    to_json(writer, stats.adaptations);
+    if (!stats.audio.encoder.empty())
+    {
+        writer.key("audio");
+        to_json(writer, stats.audio);
+    }
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::timing_event_t &event)
+{
+    writer.beginObject();
+    writer.key("stage");
+    writer.value(event.stage);
+    writer.key("start");
+    writer.value(event.start);
+    writer.key("end");
+    writer.value(event.end);
+    writer.endObject();
+}
+
+template <>
+void to_json(JsonWriter &writer, const base::startup_timing_t &timing)
 {
-    return pbnjson::JObject{
-        {"options",
-         pbnjson::JObject{
-             {"option", pbnjson::JObject{{"videoDisplayMode", load_param.videoDisplayMode},
-                                         {"display-path", (int32_t)load_param.displayPath},
-                                         {"windowId", load_param.windowId}}}}},
-        {"uri", load_param.uri}};
+    writer.beginObject();
+    writer.key("events");
+    to_json(writer, timing.events);
+    writer.endObject();
 }
 
-Composer::Composer() : _dom(pbnjson::JObject()) {}
+Composer::Composer() { _writer.beginObject(); }
+
+void Composer::clear()
+{
+    _writer.clear();
+    _writer.beginObject();
+    _closed = false;
+}
 
-std::string Composer::result()
+const std::string &Composer::result()
 {
-    std::string result = _dom.stringify();
-    return result;
+    if (!_closed)
+    {
+        _writer.endObject();
+        _closed = true;
+    }
+    return _writer.str();
 }
 
 } // namespace parser
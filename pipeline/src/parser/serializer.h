@@ -19,37 +19,109 @@
 #define SRC_PARSER_SERIALIZER_H_
 
 #include "base.h"
-#include <pbnjson.hpp>
+#include <cstdint>
 #include <string>
-#include <type_traits>
+#include <vector>
 
 namespace parser
 {
 
+/**
+ * Streaming JSON writer. Values are appended to one buffer as they are written, without a
+ * DOM in between, and clear() keeps the buffer for the next document.
+ */
+class JsonWriter
+{
+public:
+    void clear();
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(const char *key);
+
+    void value(bool value);
+    void value(int32_t value);
+    void value(uint32_t value);
+    void value(int64_t value);
+    void value(uint64_t value);
+    void value(double value);
+    void value(const char *value);
+    void value(const std::string &value);
+
+    const std::string &str() const { return _buffer; }
+
+private:
+    void separate();
+    void string(const char *value, size_t length);
+
+    std::string _buffer;
+    std::vector<bool> _first; // per open object or array, nothing written in it yet
+    bool _afterKey = false;
+};
+
+template <typename T>
+void to_json(JsonWriter &writer, const T &value)
+{
+    writer.value(value);
+}
+
 template <typename T>
-pbnjson::JValue to_json(const T &value)
+void to_json(JsonWriter &writer, const std::vector<T> &values)
 {
-    return pbnjson::JValue(value);
+    writer.beginArray();
+    for (const auto &value : values)
+        to_json(writer, value);
+    writer.endArray();
 }
 
 template <>
-pbnjson::JValue to_json(const base::result_t &);
+void to_json(JsonWriter &, const base::result_t &);
+
+template <>
+void to_json(JsonWriter &, const base::source_info_t &);
 
 template <>
-pbnjson::JValue to_json(const base::source_info_t &);
+void to_json(JsonWriter &, const base::video_info_t &);
 
 template <>
-pbnjson::JValue to_json(const base::video_info_t &);
+void to_json(JsonWriter &, const base::error_t &);
 
 template <>
-pbnjson::JValue to_json(const base::error_t &);
+void to_json(JsonWriter &, const base::media_info_t &);
 
 template <>
-pbnjson::JValue to_json(const base::media_info_t &);
+void to_json(JsonWriter &, const base::load_param_t &);
 
 template <>
-pbnjson::JValue to_json(const base::load_param_t &);
+void to_json(JsonWriter &, const base::recording_status_t &);
 
+template <>
+void to_json(JsonWriter &, const base::finalized_t &);
+
+template <>
+void to_json(JsonWriter &, const base::element_stats_t &);
+
+template <>
+void to_json(JsonWriter &, const base::rate_adaptation_t &);
+
+template <>
+void to_json(JsonWriter &, const base::audio_stats_t &);
+
+template <>
+void to_json(JsonWriter &, const base::pipeline_stats_t &);
+
+template <>
+void to_json(JsonWriter &, const base::timing_event_t &);
+
+template <>
+void to_json(JsonWriter &, const base::startup_timing_t &);
+
+/**
+ * Composes one JSON object with JsonWriter. A Composer kept around, e.g. thread_local,
+ * reuses its buffer from one document to the next.
+ */
 class Composer
 {
 public:
@@ -58,7 +130,8 @@ public:
     template <typename T>
     void put(const char *key, const T &value)
     {
-        _dom.put(key, to_json(value));
+        _writer.key(key);
+        to_json(_writer, value);
     }
 
     template <typename T>
@@ -67,16 +140,23 @@ public:
         put(key.c_str(), value);
     }
 
+    // The whole document is value.
     template <typename T>
     void put(const T &value)
     {
-        _dom = std::move(to_json(value));
+        _writer.clear();
+        to_json(_writer, value);
+        _closed = true;
     }
 
-    std::string result();
+    // Starts a new object, keeping the buffer.
+    void clear();
+
+    const std::string &result();
 
 private:
-    pbnjson::JValue _dom;
+    JsonWriter _writer;
+    bool _closed = false;
 };
 
 } // namespace parser
@@ -3,11 +3,19 @@
 
 static const std::string gst_element_json_path = "/etc/g-record-pipeline/gst_elements.conf";
 
+// Looked up several times while a pipeline is built, the file is only parsed once.
+pbnjson::JValue ElementFactory::GetConfig()
+{
+    static const pbnjson::JValue root =
+        pbnjson::JDomParser::fromFile(gst_element_json_path.c_str());
+    return root;
+}
+
 std::string ElementFactory::GetPreferredElementName(const std::string &pipelineType,
                                                     const std::string &elementTypeName)
 {
     std::string elementName = "";
-    pbnjson::JValue root    = pbnjson::JDomParser::fromFile(gst_element_json_path.c_str());
+    pbnjson::JValue root    = GetConfig();
     if (!root.isObject())
     {
         LOGE("Gst element file parsing error");
@@ -40,7 +48,7 @@ std::string ElementFactory::GetPreferredElementName(const std::string &pipelineT
 void ElementFactory::SetProperties(const std::string &pipelineType, GstElement *element,
                                    const std::string &elementTypeName)
 {
-    pbnjson::JValue root = pbnjson::JDomParser::fromFile(gst_element_json_path.c_str());
+    pbnjson::JValue root = GetConfig();
     if (!root.isObject())
     {
         LOGE("Gst element file parsing error");
@@ -68,6 +76,64 @@ void ElementFactory::SetProperties(const std::string &pipelineType, GstElement *
     }
 }
 
+std::vector<std::string> ElementFactory::GetElementNames(const std::string &pipelineType)
+{
+    std::vector<std::string> names;
+    pbnjson::JValue root = GetConfig();
+    if (!root.isObject())
+    {
+        LOGE("Gst element file parsing error");
+        return names;
+    }
+
+    pbnjson::JValue gstElements = root["gst_elements"];
+    for (const auto &elements : gstElements.items())
+    {
+        if (elements.hasKey("pipeline-type") &&
+            pipelineType == elements["pipeline-type"].asString())
+        {
+            for (const auto &it : elements.children())
+            {
+                if (it.second.isObject() && it.second.hasKey("name"))
+                    names.push_back(it.second["name"].asString());
+            }
+            break;
+        }
+    }
+
+    return names;
+}
+
+std::vector<std::string> ElementFactory::GetCandidates(const std::string &pipelineType,
+                                                      const std::string &elementTypeName)
+{
+    std::vector<std::string> candidates;
+    pbnjson::JValue root = GetConfig();
+    if (!root.isObject())
+    {
+        LOGE("Gst element file parsing error");
+        return candidates;
+    }
+
+    pbnjson::JValue gstElements = root["gst_elements"];
+    for (const auto &elements : gstElements.items())
+    {
+        if (elements.hasKey("pipeline-type") &&
+            pipelineType == elements["pipeline-type"].asString())
+        {
+            if (elements.hasKey(elementTypeName) &&
+                elements[elementTypeName].hasKey("candidates"))
+            {
+                for (const auto &it : elements[elementTypeName]["candidates"].items())
+                    candidates.push_back(it.asString());
+            }
+            break;
+        }
+    }
+
+    return candidates;
+}
+
 void ElementFactory::SetProperty(GstElement *element, const pbnjson::JValue &prop,
                                  const pbnjson::JValue &value)
 {
@@ -77,11 +143,28 @@ void ElementFactory::SetProperty(GstElement *element, const pbnjson::JValue &pro
     {
         std::string strProp      = objProp.asString();
         const gchar *elementName = gst_element_get_name(element);
-        if (objValue.isNumber())
+        GParamSpec *pspec =
+            g_object_class_find_property(G_OBJECT_GET_CLASS(element), strProp.c_str());
+        if (pspec == nullptr)
         {
-            gint32 num = objValue.asNumber<gint32>();
-            LOGI("[%s] %s: %d", elementName, strProp.c_str(), num);
-            g_object_set(G_OBJECT(element), strProp.c_str(), num, nullptr);
+            LOGI("[%s] has no property %s", elementName, strProp.c_str());
+        }
+        else if (objValue.isNumber())
+        {
+            // Converted to the type of the property, e.g. gint64 of buffer-time
+            gint64 num  = objValue.asNumber<gint64>();
+            GValue from = G_VALUE_INIT;
+            GValue to   = G_VALUE_INIT;
+            g_value_init(&from, G_TYPE_INT64);
+            g_value_set_int64(&from, num);
+            g_value_init(&to, G_PARAM_SPEC_VALUE_TYPE(pspec));
+            LOGI("[%s] %s: %" G_GINT64_FORMAT, elementName, strProp.c_str(), num);
+            if (g_value_transform(&from, &to))
+                g_object_set_property(G_OBJECT(element), strProp.c_str(), &to);
+            else
+                LOGI("Please check the value type of %s", strProp.c_str());
+            g_value_unset(&from);
+            g_value_unset(&to);
         }
         else if (objValue.isString())
         {
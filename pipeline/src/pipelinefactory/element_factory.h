@@ -4,9 +4,11 @@
 #include <gst/gst.h>
 #include <pbnjson.hpp>
 #include <string>
+#include <vector>
 
 class ElementFactory
 {
+    static pbnjson::JValue GetConfig();
     static void SetProperty(GstElement *element, const pbnjson::JValue &prop,
                             const pbnjson::JValue &value);
 
@@ -15,5 +17,8 @@ public:
                                                const std::string &elementTypeName);
     static void SetProperties(const std::string &pipelineType, GstElement *element,
                               const std::string &elementTypeName);
+    static std::vector<std::string> GetElementNames(const std::string &pipelineType);
+    static std::vector<std::string> GetCandidates(const std::string &pipelineType,
+                                                  const std::string &elementTypeName);
 };
 #endif // ELEMENT_FACTORY_H_
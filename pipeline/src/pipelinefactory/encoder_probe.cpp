@@ -0,0 +1,40 @@
+#include "encoder_probe.h"
+#include "encoder_ranking.h"
+#include "glog.h"
+#include <gst/gst.h>
+#include <pbnjson.hpp>
+
+std::string EncoderProbe::GetCheapestAudioEncoder(const std::vector<std::string> &candidates)
+{
+    pbnjson::JValue ranking = pbnjson::JDomParser::fromFile(kEncoderRankingPath);
+    if (!ranking.isObject())
+        ranking = pbnjson::Object();
+
+    std::string first;
+    std::string cheapest;
+    int64_t cheapestCpu = G_MAXINT64;
+    for (const auto &name : candidates)
+    {
+        GstElementFactory *factory = gst_element_factory_find(name.c_str());
+        if (factory == nullptr)
+            continue;
+        gst_object_unref(factory);
+
+        if (first.empty())
+            first = name;
+        if (ranking.hasKey(name) && ranking[name].asNumber<int64_t>() < cheapestCpu)
+        {
+            cheapest    = name;
+            cheapestCpu = ranking[name].asNumber<int64_t>();
+        }
+    }
+
+    if (cheapest.empty())
+    {
+        LOGI("no ranking, %s", first.empty() ? "none installed" : first.c_str());
+        return first;
+    }
+
+    LOGI("%s", cheapest.c_str());
+    return cheapest;
+}
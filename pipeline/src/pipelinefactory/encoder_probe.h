@@ -0,0 +1,18 @@
+#ifndef ENCODER_PROBE_H_
+#define ENCODER_PROBE_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * Picks the cheapest of several encoders from the ranking record_benchmark -e measured on
+ * this device (see encoder_ranking.h). Nothing is measured on load.
+ */
+class EncoderProbe
+{
+public:
+    // Returns the cheapest ranked candidate found in the registry, the first one found
+    // without a ranking, empty if there is none.
+    static std::string GetCheapestAudioEncoder(const std::vector<std::string> &candidates);
+};
+#endif // ENCODER_PROBE_H_
@@ -1,5 +1,6 @@
 #include "pipeline_factory.h"
 #include "audio_record_pipeline.h"
+#include "capture_hub_pipeline.h"
 #include "glog.h"
 #include "snapshot_pipeline.h"
 #include "video_record_pipeline.h"
@@ -30,6 +31,13 @@ std::shared_ptr<RecordPipeline> PipelineFactory::CreateRecorder(const pbnjson::J
             LOGI("Create Snapshot");
             return std::make_shared<SnapshotPipeline>();
         }
+
+        const pbnjson::JValue &hub = parsed["hub"];
+        if (hub.isObject())
+        {
+            LOGI("Create Capture Hub");
+            return std::make_shared<CaptureHubPipeline>();
+        }
     }
 
     LOGE("Cant not create recoder");
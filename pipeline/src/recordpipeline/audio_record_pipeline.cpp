@@ -16,38 +16,13 @@ bool AudioRecordPipeline::launch()
     }
     else
     {
-        std::string element = ElementFactory::GetPreferredElementName(pipelineType, "audio-src");
-        if (!element.empty())
-            pipeline_desc = element + " ! queue";
-        else
-            pipeline_desc = "pulsesrc ! queue";
-
-        element = ElementFactory::GetPreferredElementName(pipelineType, "audio-converter");
-        if (!element.empty())
-            pipeline_desc += " ! " + element + " ! capsfilter name=audioCaps";
-        else
-            pipeline_desc += " ! audioconvert ! capsfilter name=audioCaps";
+        pipeline_desc = GetAudioDesc();
 
-        if (mAudioFormat.codec == "AAC")
-        {
-            element = ElementFactory::GetPreferredElementName(pipelineType, "audio-encoder-aac");
-            if (!element.empty())
-                pipeline_desc += " ! " + element + " name=audioEnc";
-            else
-                pipeline_desc += " ! avenc_aac name=audioEnc";
-        }
-        else
-        {
-            pipeline_desc += " ! avenc_aac name=audioEnc";
-        }
+        std::string muxer = GetAudioMuxer();
+        if (!muxer.empty())
+            pipeline_desc += " ! " + muxer;
 
-        element = ElementFactory::GetPreferredElementName(pipelineType, "audio-mux");
-        if (!element.empty())
-            pipeline_desc += " ! " + element;
-        else
-            pipeline_desc += " ! mp4mux";
-
-        element = ElementFactory::GetPreferredElementName(pipelineType, "audio-sink");
+        std::string element = ElementFactory::GetPreferredElementName(pipelineType, "audio-sink");
         if (!element.empty())
             pipeline_desc += " ! " + element + " name=audioSink";
         else
@@ -63,30 +38,35 @@ bool AudioRecordPipeline::launch()
         return false;
     }
 
-    // 2. Setup capsfilter
-    auto audio_caps = gst_bin_get_by_name(GST_BIN(pipeline_), "audioCaps");
-    if (audio_caps)
-    {
-        auto caps = gst_caps_new_simple("audio/x-raw", "rate", G_TYPE_INT, mAudioFormat.sampleRate,
-                                        "channels", G_TYPE_INT, mAudioFormat.channels, nullptr);
-
-        g_object_set(audio_caps, "caps", caps, nullptr);
-    }
-
-    // 3. Setup encoder
-    auto audio_enc = gst_bin_get_by_name(GST_BIN(pipeline_), "audioEnc");
-    if (audio_enc)
-    {
-        g_object_set(audio_enc, "bitrate", mAudioFormat.bitRate, nullptr);
-    }
+    // 2. Setup source, capsfilter and encoder
+    SetupAudio();
 
-    // 4. Setup sink
+    // 3. Setup sink
     auto audio_sink = gst_bin_get_by_name(GST_BIN(pipeline_), "audioSink");
     if (audio_sink)
     {
         g_object_set(audio_sink, "location", path_.c_str(), nullptr);
     }
 
+    // 4. Setup recording status
+    AddStatusProbes(nullptr, "audioSink");
+
     LOGI("end");
     return true;
 }
+
+std::string AudioRecordPipeline::GetAudioMuxer()
+{
+    if (format_ == "OGG")
+        return "oggmux";
+    if (format_ == "WAV")
+        return "wavenc";
+    // flacenc writes the file itself, and rewrites its header once stopped
+    if (format_ == "FLAC")
+        return "";
+
+    std::string element = ElementFactory::GetPreferredElementName(pipelineType, "audio-mux");
+    if (!element.empty())
+        return element;
+    return "mp4mux";
+}
@@ -8,6 +8,10 @@ class AudioRecordPipeline : public BaseRecordPipeline
 public:
     AudioRecordPipeline() { pipelineType = "AudioRecord"; }
     bool launch() override;
+
+private:
+    // muxer for the format, none when the encoder writes the file format itself
+    std::string GetAudioMuxer();
 };
 
 #endif // AUDIO_RECORD_PIPELINE_H_
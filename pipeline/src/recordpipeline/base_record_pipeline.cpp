@@ -1,11 +1,32 @@
 #include "base_record_pipeline.h"
 #include "element_factory.h"
+#include "encoder_probe.h"
+#include "flight_recorder.h"
 #include "glog.h"
 #include "message.h"
+#include "startup_timer.h"
+#include "stats_tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
 #include <iomanip>
 #include <pbnjson.hpp>
+#include <sys/stat.h>
 #include <system_error>
 
+namespace
+{
+// gst_debug.conf, read by SetGstreamerDebug()
+struct gst_config_t
+{
+    bool loaded          = false;
+    bool statsTracer     = false;
+    bool preloadPlugins  = false;
+    bool resourceManager = true;
+};
+gst_config_t gstConfig;
+} // namespace
+
 BaseRecordPipeline::BaseRecordPipeline()
 {
     LOGI("start");
@@ -58,45 +79,90 @@ bool BaseRecordPipeline::Load(const std::string &msg)
     GRPASSERT(!msg.empty());
     LOGI("start: %s", msg.c_str());
 
-    SetGstreamerDebug();
-    gst_init(NULL, NULL);
+    // 0. Check sanity.
+    if (pipeline_ != nullptr)
+    {
+        LOGE("Error. pipeline already exists.");
+        return false;
+    }
 
+    // Options and source info do not need gstreamer, so uMS is asked first and answers
+    // while gstreamer is initialized, the pipeline built and its elements opened.
     ParseOptionString(msg);
 
-    if (GetSourceInfo())
+    std::future<bool> resource;
+    bool needResource = GetSourceInfo();
+    if (needResource)
+        resource = std::async(std::launch::async, [this]() { return acquireResource(); });
+    StartupTimer::getInstance().mark("options");
+
+    // a load failing before PLAYING waits for the acquisition and gives back what it got
+    auto abandonResource = [this, &resource]()
     {
-        if (!acquireResource())
-        {
-            LOGE("resouce acquire failed!");
-            return false;
-        }
+        if (resource.valid() && resource.get())
+            releaseResource();
+    };
 
-        NotifySourceInfo();
-    }
+    gst_init(NULL, NULL);
 
-    // 0. Check sanity.
-    if (pipeline_ != nullptr)
+    if (gstConfig.statsTracer)
+        StatsTracer::getInstance().enable();
+    StartupTimer::getInstance().mark("gst_init");
+
+    if (gstConfig.preloadPlugins)
     {
-        LOGE("Error. pipeline already exists.");
-        return false;
+        PreloadPlugins();
+        StartupTimer::getInstance().mark("preload");
     }
 
     // 1. Build pipeline and launch.
     if (!launch())
     {
         LOGE("Pipeline launch fail");
+        abandonResource();
         return false;
     }
+    StartupTimer::getInstance().mark("launch");
 
     // 2. Get Bus.
     if (!addBus())
     {
+        abandonResource();
         Unload();
         return false;
     }
 
+    if (gst_element_set_state(pipeline_, GST_STATE_READY) == GST_STATE_CHANGE_FAILURE)
+        LOGW("Failed to change pipeline state to READY");
+    StartupTimer::getInstance().mark("ready");
+
+    if (needResource)
+    {
+        bool acquired = resource.get();
+        StartupTimer::getInstance().mark("resource wait");
+
+        if (!acquired)
+        {
+            LOGE("resouce acquire failed!");
+            gst_element_set_state(pipeline_, GST_STATE_NULL);
+            remBus();
+            gst_object_unref(pipeline_);
+            pipeline_ = nullptr;
+            return false;
+        }
+
+        NotifySourceInfo();
+    }
+
     // 3. start record.
     Play();
+    StartupTimer::getInstance().mark("playing");
+
+    if (pipelineType != "Snapshot")
+    {
+        addStatusTimer();
+        addRateTimer();
+    }
 
     LOGI("end");
     return true;
@@ -108,6 +174,26 @@ bool BaseRecordPipeline::Unload()
     return unloadImpl();
 }
 
+bool BaseRecordPipeline::Stop()
+{
+    LOGI("start");
+    if (pipeline_ == nullptr)
+        return false;
+
+    remStatusTimer();
+    remRateTimer();
+
+    gint64 position = 0;
+    if (gst_element_query_position(pipeline_, GST_FORMAT_TIME, &position) && position > 0)
+        stopDuration_ = position;
+
+    // Capture ends here, Unload waits for the muxer to finalize the file.
+    sendEos();
+
+    LOGI("end");
+    return true;
+}
+
 bool BaseRecordPipeline::unloadImpl()
 {
     if (pipeline_ == nullptr)
@@ -115,9 +201,13 @@ bool BaseRecordPipeline::unloadImpl()
         return false;
     }
 
+    remStatusTimer();
+    remRateTimer();
+
     if (pipelineType != "Snapshot")
     {
         sendEos();
+        waitEos();
     }
 
     LOGI("Unload pipeline");
@@ -128,8 +218,8 @@ bool BaseRecordPipeline::unloadImpl()
         LOGW("Keep doing rest of unload procedure.");
     }
 
-    GstState state;
-    gst_element_get_state(pipeline_, &state, nullptr, GST_CLOCK_TIME_NONE);
+    GstState state = GST_STATE_VOID_PENDING;
+    gst_element_get_state(pipeline_, &state, nullptr, kStateTimeout);
     LOGI("state = %s", gst_element_state_get_name(state));
     if (state == GST_STATE_NULL)
     {
@@ -151,6 +241,18 @@ bool BaseRecordPipeline::unloadImpl()
     gst_object_unref(pipeline_);
     pipeline_ = nullptr;
 
+    for (auto &gate : pauseGates_)
+        gst_object_unref(gate->pad);
+    pauseGates_.clear();
+    paused_     = false;
+    resumeTime_ = 0;
+    pausedTime_ = 0;
+
+    if (pipelineType != "Snapshot")
+        NotifyFinalized();
+    eosSent_      = false;
+    stopDuration_ = 0;
+
     if (cbFunction_)
         cbFunction_(GRP_NOTIFY_UNLOAD_COMPLETED, 0, nullptr, nullptr);
 
@@ -159,6 +261,9 @@ bool BaseRecordPipeline::unloadImpl()
 
 void BaseRecordPipeline::sendEos()
 {
+    if (eosSent_)
+        return;
+
     GstState currentState = GST_STATE_NULL;
     gst_element_get_state(pipeline_, &currentState, nullptr, GST_SECOND);
     LOGI("state = %s", gst_element_state_get_name(currentState));
@@ -169,28 +274,77 @@ void BaseRecordPipeline::sendEos()
     }
 
     LOGI("Send EOS");
+    {
+        std::lock_guard<std::mutex> lock(eosMutex_);
+        isEos     = false;
+        busError_ = false;
+    }
+    eosSent_ = true;
     gst_element_send_event(pipeline_, gst_event_new_eos());
 
-    GstState state;
-    gst_element_get_state(pipeline_, &state, nullptr, GST_CLOCK_TIME_NONE);
-    LOGI("state = %s", gst_element_state_get_name(state));
-    if (state == GST_STATE_PAUSED)
+    // a paused pipeline only drains once playing
+    if (currentState == GST_STATE_PAUSED)
     {
         playImpl();
     }
+}
 
+void BaseRecordPipeline::waitEos()
+{
+    if (!eosSent_)
+        return;
+
+    // The muxer writes its index before the EOS reaches the sink, which takes a while
+    // for long recordings. Nobody waits on this since stop has already returned.
     LOGI("Wait for EOS");
-    int cnt = 0;
-    isEos   = false;
-    while (!isEos && cnt < 1000) // 1s
+    gint64 start = g_get_monotonic_time();
+    std::unique_lock<std::mutex> lock(eosMutex_);
+    bool done = eosCond_.wait_for(lock, std::chrono::milliseconds(kEosTimeout),
+                                  [this]() { return isEos || busError_; });
+    LOGI("%s : %" G_GINT64_FORMAT " ms", isEos ? "Got EOS" : (done ? "Error" : "Timeout"),
+         (g_get_monotonic_time() - start) / 1000);
+}
+
+void BaseRecordPipeline::NotifyFinalized()
+{
+    if (path_.empty())
+        return;
+
+    base::finalized_t finalized = {path_, stopDuration_, 0};
+    struct stat st;
+    if (stat(path_.c_str(), &st) == 0)
+        finalized.size = st.st_size;
+
+    LOGI("%s, %" PRIu64 " bytes", path_.c_str(), finalized.size);
+    if (cbFunction_)
+        cbFunction_(GRP_NOTIFY_FINALIZED, 0, nullptr, &finalized);
+}
+
+bool BaseRecordPipeline::Play()
+{
+    if (!paused_)
+        return playImpl();
+
+    // Sources ran on while paused. The gap is taken out of the running time of what they
+    // push from now on, so the recording continues right where it was paused.
+    GstClockTime now = GetRunningTime();
+    pausedTime_ += now - pauseStart_;
+    resumeTime_ = now;
+    for (auto &gate : pauseGates_)
     {
-        g_usleep(1000);
-        cnt++;
+        gate->waitKeyFrame = gate->keyFrame;
+        gst_pad_set_offset(gate->pad, -static_cast<gint64>(pausedTime_));
     }
-    LOGI("Got EOS : %d ms", cnt);
-}
+    paused_ = false;
 
-bool BaseRecordPipeline::Play() { return playImpl(); }
+    // The first frame after resume is encoded as a keyframe
+    RequestKeyFrame();
+    LOGI("resumed, paused for %" GST_TIME_FORMAT " in total", GST_TIME_ARGS(pausedTime_));
+
+    if (cbFunction_)
+        cbFunction_(GRP_NOTIFY_PLAYING, 0, nullptr, nullptr);
+    return true;
+}
 
 bool BaseRecordPipeline::playImpl()
 {
@@ -209,6 +363,22 @@ bool BaseRecordPipeline::playImpl()
 bool BaseRecordPipeline::Pause()
 {
     LOGI("start");
+
+    // Buffers are dropped at the gates instead of pausing the pipeline, which would make
+    // the sources reconnect and renegotiate on resume.
+    if (pipeline_ != nullptr && !pauseGates_.empty())
+    {
+        if (!paused_)
+        {
+            pauseStart_ = GetRunningTime();
+            paused_     = true;
+            if (cbFunction_)
+                cbFunction_(GRP_NOTIFY_PAUSED, 0, nullptr, nullptr);
+        }
+        LOGI("end");
+        return true;
+    }
+
     if (pipeline_ != nullptr &&
         gst_element_set_state(pipeline_, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
     {
@@ -226,6 +396,61 @@ void BaseRecordPipeline::RegisterCbFunction(CALLBACK_T cbf)
     cbFunction_ = std::move(cbf);
 }
 
+bool BaseRecordPipeline::GetStatistics(base::pipeline_stats_t &stats)
+{
+    stats             = StatsTracer::getInstance().getStatistics();
+    stats.adaptations = rateController_.getAdaptations();
+
+    // Capture runs in the thread of audioSrc, conversion and encoding in that of audioQueue.
+    if (!audioEncName_.empty())
+    {
+        stats.audio.source   = audioSrcName_;
+        stats.audio.encoder  = audioEncName_;
+        stats.audio.duration = audioDuration_;
+        for (const auto &element : stats.elements)
+        {
+            if (element.name == "audioSrc" || element.name == "audioQueue")
+                stats.audio.cpu_time += element.cpu_time;
+        }
+        if (stats.audio.duration > 0)
+            stats.audio.cpu_per_minute =
+                gst_util_uint64_scale(stats.audio.cpu_time, 60 * GST_SECOND, stats.audio.duration);
+    }
+
+    return stats.enabled || rateController_.isEnabled();
+}
+
+bool BaseRecordPipeline::RequestKeyFrame()
+{
+    if (pipeline_ == nullptr)
+        return false;
+
+    GstElement *encoder = gst_bin_get_by_name(GST_BIN(pipeline_), "videoEncoder");
+    if (encoder == nullptr)
+        return false;
+
+    // Same event as gst_video_event_new_upstream_force_key_unit(), without linking gstvideo.
+    GstStructure *s = gst_structure_new("GstForceKeyUnit", "running-time", G_TYPE_UINT64,
+                                        GST_CLOCK_TIME_NONE, "all-headers", G_TYPE_BOOLEAN, TRUE,
+                                        "count", G_TYPE_UINT, 0, nullptr);
+    GstEvent *event = gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM, s);
+    GstPad *pad     = gst_element_get_static_pad(encoder, "src");
+    bool ret        = false;
+    if (pad)
+    {
+        ret = gst_pad_send_event(pad, event);
+        gst_object_unref(pad);
+    }
+    else
+    {
+        gst_event_unref(event);
+    }
+    gst_object_unref(encoder);
+    LOGI("ret %d", ret);
+
+    return ret;
+}
+
 bool BaseRecordPipeline::addBus()
 {
     if (pipeline_ == nullptr)
@@ -272,9 +497,510 @@ bool BaseRecordPipeline::remBus()
     return true;
 }
 
+uint32_t BaseRecordPipeline::addTimeout(uint32_t interval, GSourceFunc func)
+{
+    GSource *s = g_timeout_source_new(interval);
+    g_source_set_callback(s, func, this, nullptr);
+    g_source_attach(s, g_main_loop_get_context(loop_));
+    uint32_t id = g_source_get_id(s);
+    g_source_unref(s);
+
+    return id;
+}
+
+void BaseRecordPipeline::removeSource(uint32_t &id)
+{
+    if (id == 0)
+        return;
+
+    GSource *s = g_main_context_find_source_by_id(g_main_loop_get_context(loop_), id);
+    if (s != nullptr)
+        g_source_destroy(s);
+
+    id = 0;
+}
+
+bool BaseRecordPipeline::addStatusTimer()
+{
+    if (statusInterval_ == 0 || statusId_ != 0)
+        return false;
+    LOGI("interval %u ms", statusInterval_);
+
+    auto callback = +[](gpointer data) -> gboolean
+    {
+        static_cast<BaseRecordPipeline *>(data)->NotifyRecordingStatus();
+        return G_SOURCE_CONTINUE;
+    };
+
+    lastStatusTime_ = g_get_monotonic_time();
+    statusId_       = addTimeout(statusInterval_, callback);
+
+    return true;
+}
+
+bool BaseRecordPipeline::remStatusTimer()
+{
+    if (statusId_ == 0)
+        return false;
+    LOGI("start");
+
+    removeSource(statusId_);
+
+    return true;
+}
+
+bool BaseRecordPipeline::addRateTimer()
+{
+    if (!rateController_.isEnabled() || rateId_ != 0)
+        return false;
+    LOGI("interval %u ms", kRateInterval);
+
+    auto callback = +[](gpointer data) -> gboolean
+    {
+        static_cast<BaseRecordPipeline *>(data)->UpdateRate();
+        return G_SOURCE_CONTINUE;
+    };
+
+    rateStartTime_ = g_get_monotonic_time();
+    rateId_        = addTimeout(kRateInterval, callback);
+
+    return true;
+}
+
+bool BaseRecordPipeline::remRateTimer()
+{
+    if (rateId_ == 0)
+        return false;
+    LOGI("start");
+
+    removeSource(rateId_);
+
+    return true;
+}
+
+void BaseRecordPipeline::AddStatusProbes(const char *encoderName, const char *sinkName)
+{
+    if (pipeline_ == nullptr)
+        return;
+
+    // Encoded frames are counted on the encoder output.
+    GstElement *encoder =
+        encoderName ? gst_bin_get_by_name(GST_BIN(pipeline_), encoderName) : nullptr;
+    if (encoder)
+    {
+        GstPad *pad = gst_element_get_static_pad(encoder, "src");
+        if (pad)
+        {
+            gst_pad_add_probe(
+                pad, GST_PAD_PROBE_TYPE_BUFFER,
+                +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+                {
+                    BaseRecordPipeline *p = static_cast<BaseRecordPipeline *>(data);
+                    if (p->framesEncoded_++ == 0)
+                        StartupTimer::getInstance().mark("first frame encoded");
+                    p->encodedBytes_ += gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info));
+                    return GST_PAD_PROBE_OK;
+                },
+                this, nullptr);
+            gst_object_unref(pad);
+        }
+        gst_object_unref(encoder);
+    }
+
+    // Bytes are counted on what reaches the file.
+    GstElement *sink = sinkName ? gst_bin_get_by_name(GST_BIN(pipeline_), sinkName) : nullptr;
+    if (sink)
+    {
+        GstPad *pad = gst_element_get_static_pad(sink, "sink");
+        if (pad)
+        {
+            gst_pad_add_probe(
+                pad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+                {
+                    BaseRecordPipeline *p = static_cast<BaseRecordPipeline *>(data);
+                    uint64_t written      = 0;
+                    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER)
+                        written = p->bytesWritten_.fetch_add(
+                            gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info)));
+                    else
+                        written = p->bytesWritten_.fetch_add(
+                            gst_buffer_list_calculate_size(GST_PAD_PROBE_INFO_BUFFER_LIST(info)));
+
+                    if (written == 0)
+                        p->NotifyStartupTiming();
+                    return GST_PAD_PROBE_OK;
+                },
+                this, nullptr);
+            gst_object_unref(pad);
+        }
+        gst_object_unref(sink);
+    }
+}
+
+std::string BaseRecordPipeline::GetAudioDesc()
+{
+    // pulsesrc, or alsasrc to capture from the device without PulseAudio. buffer-time and
+    // latency-time come from the properties of audio-src.
+    audioSrcName_ = ElementFactory::GetPreferredElementName(pipelineType, "audio-src");
+    if (audioSrcName_.empty())
+        audioSrcName_ = "pulsesrc";
+    std::string desc = audioSrcName_ + " name=audioSrc ! queue name=audioQueue";
+
+    std::string element = ElementFactory::GetPreferredElementName(pipelineType, "audio-converter");
+    if (!element.empty())
+        desc += " ! " + element + " ! capsfilter name=audioCaps";
+    else
+        desc += " ! audioconvert ! capsfilter name=audioCaps";
+
+    // PCM goes to the muxer as captured
+    audioEncName_.clear();
+    if (mAudioFormat.codec == "PCM")
+        return desc;
+
+    if (mAudioFormat.codec == "OPUS")
+    {
+        audioEncName_ = ElementFactory::GetPreferredElementName(pipelineType, "audio-encoder-opus");
+        if (audioEncName_.empty())
+            audioEncName_ = "opusenc";
+    }
+    else if (mAudioFormat.codec == "FLAC")
+    {
+        audioEncName_ = ElementFactory::GetPreferredElementName(pipelineType, "audio-encoder-flac");
+        if (audioEncName_.empty())
+            audioEncName_ = "flacenc";
+    }
+    else
+    {
+        // Without a preferred AAC encoder, the cheapest of the candidates measured on this device
+        audioEncName_ = ElementFactory::GetPreferredElementName(pipelineType, "audio-encoder-aac");
+        if (audioEncName_.empty())
+            audioEncName_ = EncoderProbe::GetCheapestAudioEncoder(
+                ElementFactory::GetCandidates(pipelineType, "audio-encoder-aac"));
+        if (audioEncName_.empty())
+            audioEncName_ = "avenc_aac";
+    }
+    desc += " ! " + audioEncName_ + " name=audioEnc";
+
+    return desc;
+}
+
+void BaseRecordPipeline::SetupAudio()
+{
+    GstElement *audio_src = gst_bin_get_by_name(GST_BIN(pipeline_), "audioSrc");
+    if (audio_src)
+    {
+        ElementFactory::SetProperties(pipelineType, audio_src, "audio-src");
+        gst_object_unref(audio_src);
+    }
+
+    GstElement *audio_caps = gst_bin_get_by_name(GST_BIN(pipeline_), "audioCaps");
+    if (audio_caps)
+    {
+        auto caps = gst_caps_new_simple("audio/x-raw", "rate", G_TYPE_INT, mAudioFormat.sampleRate,
+                                        "channels", G_TYPE_INT, mAudioFormat.channels, nullptr);
+        g_object_set(audio_caps, "caps", caps, nullptr);
+        gst_caps_unref(caps);
+        gst_object_unref(audio_caps);
+    }
+
+    // The duration of the audio is counted after the encoder, or after the caps of PCM.
+    GstElement *audio_enc = gst_bin_get_by_name(GST_BIN(pipeline_), "audioEnc");
+    if (audio_enc == nullptr)
+        audio_enc = gst_bin_get_by_name(GST_BIN(pipeline_), "audioCaps");
+    if (audio_enc == nullptr)
+        return;
+
+    // flacenc has no bitrate, it is lossless
+    if (mAudioFormat.bitRate > 0 &&
+        g_object_class_find_property(G_OBJECT_GET_CLASS(audio_enc), "bitrate"))
+        g_object_set(audio_enc, "bitrate", mAudioFormat.bitRate, nullptr);
+
+    GstPad *pad = gst_element_get_static_pad(audio_enc, "src");
+    if (pad)
+    {
+        gst_pad_add_probe(
+            pad, GST_PAD_PROBE_TYPE_BUFFER,
+            +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+            {
+                BaseRecordPipeline *p = static_cast<BaseRecordPipeline *>(data);
+                GstBuffer *buffer     = GST_PAD_PROBE_INFO_BUFFER(info);
+                if (GST_BUFFER_DURATION_IS_VALID(buffer))
+                    p->audioDuration_ += GST_BUFFER_DURATION(buffer);
+                return GST_PAD_PROBE_OK;
+            },
+            this, nullptr);
+        gst_object_unref(pad);
+    }
+    gst_object_unref(audio_enc);
+
+    AddPauseGate("audioSrc", false);
+}
+
+GstClockTime BaseRecordPipeline::GetRunningTime()
+{
+    GstClock *clock = gst_element_get_clock(pipeline_);
+    if (clock == nullptr)
+        return 0;
+
+    GstClockTime now = gst_clock_get_time(clock) - gst_element_get_base_time(pipeline_);
+    gst_object_unref(clock);
+    return now;
+}
+
+void BaseRecordPipeline::AddPauseGate(const char *elementName, bool keyFrame)
+{
+    GstElement *element = gst_bin_get_by_name(GST_BIN(pipeline_), elementName);
+    if (element == nullptr)
+        return;
+
+    GstPad *pad = gst_element_get_static_pad(element, "src");
+    if (pad)
+    {
+        auto gate      = std::make_unique<pause_gate_t>();
+        gate->pipeline = this;
+        gate->pad      = pad;
+        gate->keyFrame = keyFrame;
+        gst_pad_add_probe(
+            pad, GST_PAD_PROBE_TYPE_BUFFER,
+            +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+            {
+                auto *gate = static_cast<pause_gate_t *>(data);
+                return gate->pipeline->passPauseGate(gate, GST_PAD_PROBE_INFO_BUFFER(info))
+                           ? GST_PAD_PROBE_OK
+                           : GST_PAD_PROBE_DROP;
+            },
+            gate.get(), nullptr);
+        pauseGates_.push_back(std::move(gate));
+    }
+    gst_object_unref(element);
+}
+
+bool BaseRecordPipeline::passPauseGate(pause_gate_t *gate, GstBuffer *buffer)
+{
+    if (paused_)
+        return false;
+
+    // captured while paused, but pushed after resume
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    if (GST_CLOCK_TIME_IS_VALID(pts) && pts < resumeTime_)
+        return false;
+
+    if (gate->waitKeyFrame)
+    {
+        if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+            return false;
+
+        gate->waitKeyFrame = false;
+        LOGI("resumed at keyframe %" GST_TIME_FORMAT, GST_TIME_ARGS(pts));
+    }
+    return true;
+}
+
+void BaseRecordPipeline::NotifyStartupTiming()
+{
+    StartupTimer::getInstance().mark("first buffer written");
+
+    // Called from the streaming thread, subscribers are notified from the loop.
+    addTimeout(0,
+               +[](gpointer data) -> gboolean
+               {
+                   BaseRecordPipeline *p         = static_cast<BaseRecordPipeline *>(data);
+                   base::startup_timing_t timing = StartupTimer::getInstance().getTiming();
+                   if (p->cbFunction_)
+                       p->cbFunction_(GRP_NOTIFY_STARTUP_TIMING, 0, nullptr, &timing);
+                   return G_SOURCE_REMOVE;
+               });
+}
+
+void BaseRecordPipeline::NotifyRecordingStatus()
+{
+    base::recording_status_t status = {};
+
+    gint64 position = 0;
+    if (gst_element_query_position(pipeline_, GST_FORMAT_TIME, &position) && position > 0)
+        status.duration = position;
+
+    status.bytes  = bytesWritten_;
+    status.frames = framesEncoded_;
+    for (const auto &it : qosDropped_)
+        status.dropped += it.second;
+
+    gint64 now = g_get_monotonic_time();
+    if (now > lastStatusTime_)
+    {
+        gint64 elapsed = now - lastStatusTime_;
+        status.bitrate = (status.bytes - lastBytes_) * 8 * G_USEC_PER_SEC / elapsed;
+        status.fps     = (double)(status.frames - lastFrames_) * G_USEC_PER_SEC / elapsed;
+    }
+    lastStatusTime_ = now;
+    lastBytes_      = status.bytes;
+    lastFrames_     = status.frames;
+    flight::record(flight::EV_BUFFERS, status.frames, status.bytes);
+
+    if (cbFunction_)
+        cbFunction_(GRP_NOTIFY_RECORDING_STATUS, 0, nullptr, &status);
+}
+
+void BaseRecordPipeline::AddRateControl(const char *encoderName, const char *encoderQueueName,
+                                        const char *muxQueueName)
+{
+    rateController_.configure(mVideoFormat.bitRate, mVideoFormat.minBitRate, mVideoFormat.fps,
+                              mVideoFormat.minFps);
+    if (!rateController_.isEnabled() || pipeline_ == nullptr)
+        return;
+
+    encoderName_      = encoderName ? encoderName : "";
+    encoderQueueName_ = encoderQueueName ? encoderQueueName : "";
+    muxQueueName_     = muxQueueName ? muxQueueName : "";
+    targetFps_        = mVideoFormat.fps;
+    rateLastBitRate_  = mVideoFormat.bitRate;
+
+    // Frames are skipped before they are queued for the encoder when the framerate is lowered.
+    GstElement *element = gst_bin_get_by_name(
+        GST_BIN(pipeline_), encoderQueueName ? encoderQueueName : encoderName_.c_str());
+    if (element)
+    {
+        GstPad *pad = gst_element_get_static_pad(element, "sink");
+        if (pad)
+        {
+            gst_pad_add_probe(
+                pad, GST_PAD_PROBE_TYPE_BUFFER,
+                +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+                {
+                    BaseRecordPipeline *p = static_cast<BaseRecordPipeline *>(data);
+                    return p->skipFrame(GST_PAD_PROBE_INFO_BUFFER(info)) ? GST_PAD_PROBE_DROP
+                                                                         : GST_PAD_PROBE_OK;
+                },
+                this, nullptr);
+            gst_object_unref(pad);
+        }
+        gst_object_unref(element);
+    }
+}
+
+bool BaseRecordPipeline::skipFrame(GstBuffer *buffer)
+{
+    uint32_t fps     = targetFps_;
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    if (fps == 0 || fps >= mVideoFormat.fps || !GST_CLOCK_TIME_IS_VALID(pts))
+    {
+        lastKeptPts_ = pts;
+        return false;
+    }
+
+    // Keep a frame once 90% of the target frame duration has passed, to absorb jitter.
+    if (GST_CLOCK_TIME_IS_VALID(lastKeptPts_) && pts >= lastKeptPts_ &&
+        pts - lastKeptPts_ < gst_util_uint64_scale_int(GST_SECOND, 9, fps * 10))
+    {
+        return true;
+    }
+
+    lastKeptPts_ = pts;
+    return false;
+}
+
+double BaseRecordPipeline::GetQueueFill(const std::string &name)
+{
+    GstElement *queue =
+        name.empty() ? nullptr : gst_bin_get_by_name(GST_BIN(pipeline_), name.c_str());
+    if (queue == nullptr)
+        return 0;
+
+    guint buffers    = 0;
+    guint maxBuffers = 0;
+    guint64 time     = 0;
+    guint64 maxTime  = 0;
+    g_object_get(queue, "current-level-buffers", &buffers, "max-size-buffers", &maxBuffers,
+                 "current-level-time", &time, "max-size-time", &maxTime, nullptr);
+    gst_object_unref(queue);
+
+    double fill = 0;
+    if (maxBuffers > 0)
+        fill = (double)buffers / maxBuffers;
+    if (maxTime > 0)
+        fill = std::max(fill, (double)time / maxTime);
+
+    return fill;
+}
+
+void BaseRecordPipeline::SetEncoderBitRate(uint32_t bitRate)
+{
+    if (encoderName_.empty() || bitRate == 0)
+        return;
+
+    GstElement *encoder = gst_bin_get_by_name(GST_BIN(pipeline_), encoderName_.c_str());
+    if (encoder == nullptr)
+        return;
+
+    GObjectClass *klass = G_OBJECT_GET_CLASS(encoder);
+    if (g_object_class_find_property(klass, "extra-controls"))
+    {
+        // v4l2 encoders take the bitrate as a control, which applies while streaming.
+        GstStructure *controls =
+            gst_structure_new("controls", "video_bitrate", G_TYPE_INT, (gint)bitRate, nullptr);
+        g_object_set(encoder, "extra-controls", controls, nullptr);
+        gst_structure_free(controls);
+    }
+    else if (g_object_class_find_property(klass, "bitrate"))
+    {
+        // x264enc counts in kbit/s, the others in bit/s.
+        GstElementFactory *factory = gst_element_get_factory(encoder);
+        bool kbps = factory && g_strcmp0(GST_OBJECT_NAME(factory), "x264enc") == 0;
+
+        GValue value = G_VALUE_INIT;
+        g_value_init(&value, G_TYPE_UINT);
+        g_value_set_uint(&value, kbps ? bitRate / 1000 : bitRate);
+        g_object_set_property(G_OBJECT(encoder), "bitrate", &value);
+        g_value_unset(&value);
+    }
+    else
+    {
+        LOGW("%s has no bitrate control", encoderName_.c_str());
+    }
+
+    gst_object_unref(encoder);
+}
+
+void BaseRecordPipeline::UpdateRate()
+{
+    uint64_t dropped = 0;
+    for (const auto &it : qosDropped_)
+        dropped += it.second;
+    uint64_t encoded = encodedBytes_;
+    uint64_t written = bytesWritten_;
+
+    RateController::sample_t sample = {};
+    sample.dropped                  = dropped > rateLastDropped_ ? dropped - rateLastDropped_ : 0;
+    sample.encoderFill              = GetQueueFill(encoderQueueName_);
+    sample.muxFill                  = GetQueueFill(muxQueueName_);
+    sample.encoded                  = encoded - rateLastEncoded_;
+    sample.written                  = written - rateLastWritten_;
+
+    rateLastDropped_ = dropped;
+    rateLastEncoded_ = encoded;
+    rateLastWritten_ = written;
+
+    // nothing is encoded while paused, that is not congestion
+    if (paused_)
+        return;
+
+    uint64_t time = (g_get_monotonic_time() - rateStartTime_) * 1000;
+    if (!rateController_.update(sample, time))
+        return;
+
+    if (rateController_.getBitRate() != rateLastBitRate_)
+    {
+        rateLastBitRate_ = rateController_.getBitRate();
+        SetEncoderBitRate(rateLastBitRate_);
+    }
+    targetFps_ = rateController_.getFps();
+}
+
 bool BaseRecordPipeline::acquireResource()
 {
     LOGI("start");
+    gint64 start = g_get_monotonic_time();
     ACQUIRE_RESOURCE_INFO_T resource_info;
     resource_info.sourceInfo  = &source_info_;
     resource_info.displayMode = display_mode_.c_str();
@@ -283,6 +1009,7 @@ bool BaseRecordPipeline::acquireResource()
     if (cbFunction_)
         cbFunction_(GRP_NOTIFY_ACQUIRE_RESOURCE, display_path_, nullptr,
                     static_cast<void *>(&resource_info));
+    StartupTimer::getInstance().add("resource acquisition", start);
 
     if (!resource_info.result)
     {
@@ -293,11 +1020,23 @@ bool BaseRecordPipeline::acquireResource()
     return true;
 }
 
+void BaseRecordPipeline::releaseResource()
+{
+    LOGI("");
+    if (cbFunction_)
+        cbFunction_(GRP_NOTIFY_RELEASE_RESOURCE, 0, nullptr, nullptr);
+}
+
 bool BaseRecordPipeline::GetSourceInfo()
 {
     base::video_info_t video_stream_info = {};
 
-    if (!mVideoFormat.empty())
+    if (!sharedEncoderPath_.empty())
+    {
+        // The encoder hub holds the encoder resource for all recordings sharing it.
+        return false;
+    }
+    else if (!mVideoFormat.empty())
     {
         video_stream_info.width          = mVideoFormat.width;
         video_stream_info.height         = mVideoFormat.height;
@@ -350,8 +1089,9 @@ bool BaseRecordPipeline::handleBusMessage(GstBus *bus, GstMessage *msg)
     auto msgType = GST_MESSAGE_TYPE(msg);
     if (msgType != GST_MESSAGE_QOS && msgType != GST_MESSAGE_TAG)
     {
-        LOGI("Element[ %s ][ %d ][ %s ]", GST_MESSAGE_SRC_NAME(msg), msgType,
+        LOGD("Element[ %s ][ %d ][ %s ]", GST_MESSAGE_SRC_NAME(msg), msgType,
              gst_message_type_get_name(msgType));
+        flight::record(flight::EV_BUS_MESSAGE, msgType, 0, GST_MESSAGE_SRC_NAME(msg));
     }
 
     switch (GST_MESSAGE_TYPE(msg))
@@ -360,6 +1100,14 @@ bool BaseRecordPipeline::handleBusMessage(GstBus *bus, GstMessage *msg)
     {
         LOGE("Got Error");
         base::error_t error = HandleErrorMessage(msg);
+        flight::record(flight::EV_ERROR, error.errorCode, 0, GST_MESSAGE_SRC_NAME(msg));
+        flight::dump("error");
+        {
+            // no EOS is coming after this
+            std::lock_guard<std::mutex> lock(eosMutex_);
+            busError_ = true;
+        }
+        eosCond_.notify_all();
         if (cbFunction_)
             cbFunction_(GRP_NOTIFY_ERROR, 0, nullptr, &error);
         GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(pipeline_), GST_DEBUG_GRAPH_SHOW_VERBOSE, "grp_error");
@@ -368,8 +1116,11 @@ bool BaseRecordPipeline::handleBusMessage(GstBus *bus, GstMessage *msg)
     case GST_MESSAGE_EOS:
     {
         LOGI("Got EOS");
-
-        isEos = true;
+        {
+            std::lock_guard<std::mutex> lock(eosMutex_);
+            isEos = true;
+        }
+        eosCond_.notify_all();
 
         if (cbFunction_)
             cbFunction_(GRP_NOTIFY_END_OF_STREAM, 0, nullptr, nullptr);
@@ -381,6 +1132,25 @@ bool BaseRecordPipeline::handleBusMessage(GstBus *bus, GstMessage *msg)
 
         break;
     }
+    case GST_MESSAGE_QOS:
+    {
+        GstFormat format;
+        guint64 processed = 0;
+        guint64 dropped   = 0;
+        gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+        if ((format == GST_FORMAT_BUFFERS || format == GST_FORMAT_DEFAULT) &&
+            dropped != static_cast<guint64>(-1))
+        {
+            guint64 &last = qosDropped_[GST_MESSAGE_SRC_NAME(msg)];
+            if (dropped > last)
+            {
+                LOGW_EVERY_MS(1000, "%s dropped %" G_GUINT64_FORMAT " frames in total",
+                              GST_MESSAGE_SRC_NAME(msg), dropped);
+            }
+            last = dropped;
+        }
+        break;
+    }
     case GST_MESSAGE_ASYNC_DONE:
     {
         LOGI("Got AsyncDone");
@@ -388,12 +1158,14 @@ bool BaseRecordPipeline::handleBusMessage(GstBus *bus, GstMessage *msg)
     }
     case GST_MESSAGE_STATE_CHANGED:
     {
-        if (GST_MESSAGE_SRC(msg) != GST_OBJECT_CAST(pipeline_))
-            break;
-
         GstState oldState = GST_STATE_NULL;
         GstState newState = GST_STATE_NULL;
         gst_message_parse_state_changed(msg, &oldState, &newState, nullptr);
+        flight::record(flight::EV_STATE, oldState, newState, GST_MESSAGE_SRC_NAME(msg));
+
+        if (GST_MESSAGE_SRC(msg) != GST_OBJECT_CAST(pipeline_))
+            break;
+
         LOGI("Element[%s] State changed ...%s -> %s", GST_MESSAGE_SRC_NAME(msg),
              gst_element_state_get_name(oldState), gst_element_state_get_name(newState));
 
@@ -463,6 +1235,30 @@ bool BaseRecordPipeline::handleBusMessage(GstBus *bus, GstMessage *msg)
     return true;
 }
 
+static std::vector<composite_src_t> parseCompositeSrcs(pbnjson::JValue srcs)
+{
+    std::vector<composite_src_t> result;
+    for (ssize_t i = 0; srcs.isArray() && i < srcs.arraySize(); i++)
+    {
+        pbnjson::JValue src = srcs[i];
+
+        composite_src_t compositeSrc;
+        compositeSrc.videoSrc  = src["videoSrc"].asString();
+        compositeSrc.width     = src["width"].asNumber<int>();
+        compositeSrc.height    = src["height"].asNumber<int>();
+        compositeSrc.x         = src["x"].asNumber<int>();
+        compositeSrc.y         = src["y"].asNumber<int>();
+        compositeSrc.outWidth  = src["outWidth"].asNumber<int>();
+        compositeSrc.outHeight = src["outHeight"].asNumber<int>();
+        result.push_back(compositeSrc);
+
+        LOGI("camera %zd : %s %ux%u -> %ux%u+%u+%u", i, compositeSrc.videoSrc.c_str(),
+             compositeSrc.width, compositeSrc.height, compositeSrc.outWidth,
+             compositeSrc.outHeight, compositeSrc.x, compositeSrc.y);
+    }
+    return result;
+}
+
 void BaseRecordPipeline::ParseOptionString(const std::string &options)
 {
     LOGI("option string: %s", options.c_str());
@@ -491,6 +1287,11 @@ void BaseRecordPipeline::ParseOptionString(const std::string &options)
     {
         path_ = parsed["path"].asString();
     }
+    if (parsed.hasKey("statusInterval"))
+    {
+        int32_t interval = parsed["statusInterval"].asNumber<int32_t>();
+        statusInterval_  = (interval > 0 ? interval : 0);
+    }
 
     pbnjson::JValue video = parsed["video"];
     if (video.isObject())
@@ -503,6 +1304,19 @@ void BaseRecordPipeline::ParseOptionString(const std::string &options)
         mVideoFormat.height  = video["height"].asNumber<int>();
         mVideoFormat.fps     = video["fps"].asNumber<int>();
         mVideoFormat.bitRate = video["bitRate"].asNumber<int>();
+        if (video.hasKey("hubSocketPath"))
+            hubSocketPath_ = video["hubSocketPath"].asString();
+        if (video.hasKey("encoderHubPath"))
+            encoderHubPath_ = video["encoderHubPath"].asString();
+        if (video.hasKey("sharedEncoderPath"))
+            sharedEncoderPath_ = video["sharedEncoderPath"].asString();
+        if (video.hasKey("minBitRate"))
+            mVideoFormat.minBitRate = video["minBitRate"].asNumber<int>();
+        if (video.hasKey("minFps"))
+            mVideoFormat.minFps = video["minFps"].asNumber<int>();
+
+        compositeSrcs_ = parseCompositeSrcs(video["composite"]);
+        trackSrcs_     = parseCompositeSrcs(video["tracks"]);
 
         LOGI("=== video ===");
         LOGI("videoSrc : %s", video_src_.c_str());
@@ -511,6 +1325,47 @@ void BaseRecordPipeline::ParseOptionString(const std::string &options)
         LOGI("codec : %s", mVideoFormat.codec.c_str());
         LOGI("fps: %d", mVideoFormat.fps);
         LOGI("bitRate : %d", mVideoFormat.bitRate);
+        LOGI("minBitRate : %d", mVideoFormat.minBitRate);
+        LOGI("minFps : %d", mVideoFormat.minFps);
+    }
+
+    pbnjson::JValue hub = parsed["hub"];
+    if (hub.isObject())
+    {
+        video_src_        = hub["videoSrc"].asString();
+        hubSocketPath_    = hub["socketPath"].asString();
+        hubFormat_.codec  = hub_video_format;
+        hubFormat_.width  = hub["width"].asNumber<int>();
+        hubFormat_.height = hub["height"].asNumber<int>();
+
+        LOGI("=== hub ===");
+        LOGI("videoSrc : %s", video_src_.c_str());
+        LOGI("socketPath : %s", hubSocketPath_.c_str());
+        LOGI("width : %d", hubFormat_.width);
+        LOGI("height : %d", hubFormat_.height);
+    }
+
+    pbnjson::JValue live = parsed["liveOutput"];
+    if (live.isObject())
+    {
+        liveType_ = live["type"].asString();
+        if (live.hasKey("port"))
+            livePort_ = live["port"].asNumber<int>();
+        if (live.hasKey("path"))
+            livePath_ = live["path"].asString();
+
+        LOGI("=== live output ===");
+        LOGI("type : %s", liveType_.c_str());
+        LOGI("port : %d", livePort_);
+        LOGI("path : %s", livePath_.c_str());
+    }
+
+    pbnjson::JValue tap = parsed["encodedTap"];
+    if (tap.isObject())
+    {
+        tapSocketPath_ = tap["socketPath"].asString();
+        LOGI("=== encoded tap ===");
+        LOGI("socketPath : %s", tapSocketPath_.c_str());
     }
 
     pbnjson::JValue audio = parsed["audio"];
@@ -539,6 +1394,8 @@ void BaseRecordPipeline::ParseOptionString(const std::string &options)
         mImageFormat.width   = image["width"].asNumber<int>();
         mImageFormat.height  = image["height"].asNumber<int>();
         mImageFormat.quality = image["quality"].asNumber<int>();
+        if (image.hasKey("hubSocketPath"))
+            hubSocketPath_ = image["hubSocketPath"].asString();
 
         LOGI("=== image ===");
         LOGI("videoSrc : %s", video_src_.c_str());
@@ -556,12 +1413,33 @@ void BaseRecordPipeline::ParseOptionString(const std::string &options)
 
 void BaseRecordPipeline::SetGstreamerDebug()
 {
+    if (gstConfig.loaded)
+        return;
+    gstConfig.loaded = true;
+
     pbnjson::JValue parsed = pbnjson::JDomParser::fromFile("/etc/g-record-pipeline/gst_debug.conf");
     if (!parsed.isObject())
     {
         LOGE("Gst debug file parsing error");
     }
 
+    if (parsed.hasKey("stats_tracer"))
+        gstConfig.statsTracer = parsed["stats_tracer"].asBool();
+    if (parsed.hasKey("preload_plugins"))
+        gstConfig.preloadPlugins = parsed["preload_plugins"].asBool();
+    if (parsed.hasKey("resource_manager"))
+        gstConfig.resourceManager = parsed["resource_manager"].asBool();
+
+    // With a prebuilt registry the plugin directories are not scanned on start. Without one
+    // yet, the first start scans them and writes the cache.
+    std::string registry = parsed["registry_cache"].asString();
+    if (!registry.empty())
+    {
+        setenv("GST_REGISTRY", registry.c_str(), 1);
+        if (g_file_test(registry.c_str(), G_FILE_TEST_EXISTS))
+            setenv("GST_REGISTRY_UPDATE", "no", 1);
+    }
+
     pbnjson::JValue debug = parsed["gst_debug"];
     int size              = debug.arraySize();
     for (int i = 0; i < size; i++)
@@ -578,6 +1456,31 @@ void BaseRecordPipeline::SetGstreamerDebug()
     }
 }
 
+bool BaseRecordPipeline::UseResourceManager()
+{
+    return gstConfig.resourceManager;
+}
+
+void BaseRecordPipeline::PreloadPlugins()
+{
+    // Only the plugins of the elements this pipeline type is configured with
+    for (const auto &name : ElementFactory::GetElementNames(pipelineType))
+    {
+        GstElementFactory *factory = gst_element_factory_find(name.c_str());
+        if (factory == nullptr)
+        {
+            LOGW("%s is not in the registry", name.c_str());
+            continue;
+        }
+
+        GstPluginFeature *loaded = gst_plugin_feature_load(GST_PLUGIN_FEATURE(factory));
+        LOGI("preload %s : %s", name.c_str(), loaded ? "ok" : "failed");
+        if (loaded)
+            gst_object_unref(loaded);
+        gst_object_unref(factory);
+    }
+}
+
 int32_t BaseRecordPipeline::ConvertErrorCode(GQuark domain, gint code)
 {
     int32_t converted = MEDIA_MSG_ERR_PLAYING;
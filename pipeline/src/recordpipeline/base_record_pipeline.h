@@ -4,11 +4,28 @@
 #include "base.h"
 #include "camera_types.h"
 #include "format_utils.h"
+#include "rate_controller.h"
 #include "record_pipeline.h"
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 static const std::string record_pipeline_path = "/etc/g-record-pipeline/record_pipeline";
+static const std::string hub_video_format     = "I420";
+
+// camera of a composite or multi-track recording
+struct composite_src_t
+{
+    std::string videoSrc;
+    uint32_t width, height; // camera frame
+    uint32_t x, y;          // region in the output frame, composite only
+    uint32_t outWidth, outHeight;
+};
 
 class BaseRecordPipeline : public RecordPipeline
 {
@@ -20,13 +37,70 @@ class BaseRecordPipeline : public RecordPipeline
     std::string display_mode_;
     std::string window_id_;
     base::source_info_t source_info_;
-    bool isEos = false;
+
+    // EOS sent by sendEos() and its outcome from the bus, waitEos() waits on them
+    static const uint32_t kEosTimeout = 10000; // ms
+    std::mutex eosMutex_;
+    std::condition_variable eosCond_;
+    bool isEos{false};
+    bool busError_{false};
+    bool eosSent_{false};
+
+    // longest wait for a state change, the stop and unload paths never block without bound
+    static const GstClockTime kStateTimeout = 5 * GST_SECOND;
+
+    // recording status
+    uint32_t statusId_{0};
+    uint32_t statusInterval_{1000}; // ms, 0 disables status notifications
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<uint64_t> framesEncoded_{0};
+    uint64_t lastBytes_{0};
+    uint64_t lastFrames_{0};
+    gint64 lastStatusTime_{0};
+    std::map<std::string, guint64> qosDropped_;
+
+    // adaptive rate control
+    static const uint32_t kRateInterval = 1000; // ms
+    uint32_t rateId_{0};
+    RateController rateController_;
+    std::string encoderName_, encoderQueueName_, muxQueueName_;
+    std::atomic<uint64_t> encodedBytes_{0};
+    std::atomic<uint32_t> targetFps_{0};
+    GstClockTime lastKeptPts_{GST_CLOCK_TIME_NONE};
+    uint64_t rateLastDropped_{0};
+    uint64_t rateLastEncoded_{0};
+    uint64_t rateLastWritten_{0};
+    uint32_t rateLastBitRate_{0};
+    gint64 rateStartTime_{0};
+
+    // audio branch, for the cpu time per minute of audio
+    std::string audioSrcName_, audioEncName_;
+    std::atomic<uint64_t> audioDuration_{0};
+
+    // duration of the recording when stopped, for the finalized notification
+    uint64_t stopDuration_{0};
+
+    // pause in the data path, the pipeline keeps PLAYING
+    struct pause_gate_t
+    {
+        BaseRecordPipeline *pipeline;
+        GstPad *pad;
+        bool keyFrame; // encoded already, resumes at the next keyframe
+        std::atomic<bool> waitKeyFrame{false};
+    };
+    std::vector<std::unique_ptr<pause_gate_t>> pauseGates_;
+    std::atomic<bool> paused_{false};
+    std::atomic<GstClockTime> resumeTime_{0};
+    GstClockTime pauseStart_{0};
+    GstClockTime pausedTime_{0};
 
     bool acquireResource();
+    void releaseResource();
     bool GetSourceInfo();
     void NotifySourceInfo();
     void ParseOptionString(const std::string &options);
-    void SetGstreamerDebug();
+    void PreloadPlugins();
+    void NotifyStartupTiming();
     int32_t ConvertErrorCode(GQuark domain, gint code);
     base::error_t HandleErrorMessage(GstMessage *message);
     bool handleBusMessage(GstBus *bus, GstMessage *msg);
@@ -35,6 +109,21 @@ class BaseRecordPipeline : public RecordPipeline
     bool unloadImpl();
     bool playImpl();
     void sendEos();
+    void waitEos();
+    void NotifyFinalized();
+    uint32_t addTimeout(uint32_t interval, GSourceFunc func);
+    void removeSource(uint32_t &id);
+    bool addStatusTimer();
+    bool remStatusTimer();
+    void NotifyRecordingStatus();
+    bool addRateTimer();
+    bool remRateTimer();
+    void UpdateRate();
+    bool skipFrame(GstBuffer *buffer);
+    double GetQueueFill(const std::string &name);
+    void SetEncoderBitRate(uint32_t bitRate);
+    GstClockTime GetRunningTime();
+    bool passPauseGate(pause_gate_t *gate, GstBuffer *buffer);
 
 public:
     BaseRecordPipeline();
@@ -42,18 +131,55 @@ public:
 
     bool Load(const std::string &msg) override;
     bool Unload() override;
+    bool Stop() override;
     bool Play() override;
     bool Pause() override;
     void RegisterCbFunction(CALLBACK_T cbf) override;
+    bool GetStatistics(base::pipeline_stats_t &stats) override;
+    bool RequestKeyFrame() override;
     virtual bool launch() = 0;
 
+    // Reads gst_debug.conf and exports its GST_* variables, once per process. setenv is not
+    // safe against getenv on other threads, so it has to run before any thread is started.
+    static void SetGstreamerDebug();
+    // Without uMS (e.g. benchmarks with local stand-ins) resources are not acquired at all.
+    static bool UseResourceManager();
+
 protected:
     int32_t display_path_{GRP_DEFAULT_DISPLAY};
     std::string format_, video_src_, path_;
 
+    // live output ("rtp" to udp port on loopback or "hls" into a directory)
+    std::string liveType_, livePath_;
+    uint32_t livePort_{0};
+
+    // shmsink socket publishing the encoded stream to other local processes
+    std::string tapSocketPath_;
+
+    // capture hub socket carrying converted frames of video_src_ (see CaptureHubPipeline)
+    std::string hubSocketPath_;
+    video_format_t hubFormat_;
+
+    // encoder hub: this pipeline publishes its encoded video to encoderHubPath_, or
+    // records the encoded video another pipeline publishes on sharedEncoderPath_
+    std::string encoderHubPath_;
+    std::string sharedEncoderPath_;
+
+    // cameras composited into one frame, or recorded as tracks of one file.
+    // The first one is video_src_.
+    std::vector<composite_src_t> compositeSrcs_;
+    std::vector<composite_src_t> trackSrcs_;
+
     GstElement *pipeline_{nullptr};
     std::string pipelineType;
 
+    void AddStatusProbes(const char *encoderName, const char *sinkName);
+    void AddRateControl(const char *encoderName, const char *encoderQueueName,
+                        const char *muxQueueName);
+    std::string GetAudioDesc();
+    void SetupAudio();
+    void AddPauseGate(const char *elementName, bool keyFrame);
+
     video_format_t mVideoFormat;
     audio_format_t mAudioFormat;
     image_format_t mImageFormat;
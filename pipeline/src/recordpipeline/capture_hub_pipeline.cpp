@@ -0,0 +1,56 @@
+#include "capture_hub_pipeline.h"
+#include "element_factory.h"
+#include "glog.h"
+#include <unistd.h>
+
+// frames the shm area can hold for all attached consumers together
+static const uint32_t kHubShmFrames = 8;
+
+bool CaptureHubPipeline::launch()
+{
+    LOGI("start");
+
+    if (hubSocketPath_.empty() || hubFormat_.width == 0 || hubFormat_.height == 0)
+    {
+        LOGE("Invalid hub parameters");
+        return false;
+    }
+
+    // A stale socket from a previous run would make shmsink fail to bind.
+    unlink(hubSocketPath_.c_str());
+
+    // 1. Build pipeline description and launch.
+    std::string socketPath = "/tmp/" + video_src_;
+    std::string pipeline_desc =
+        "shmsrc socket-path=" + socketPath + " is-live=true do-timestamp=true name=videoSrc";
+
+    pipeline_desc += " ! video/x-raw, width=" + std::to_string(hubFormat_.width) +
+                     ", height=" + std::to_string(hubFormat_.height) +
+                     ", format=RGB16, framerate=0/1, colorimetry=1:1:5:1";
+
+    // Conversion is done once here instead of in every recording.
+    std::string element = ElementFactory::GetPreferredElementName("VideoRecord", "video-converter");
+    pipeline_desc += " ! " + (element.empty() ? std::string("videoconvert") : element);
+    pipeline_desc += " ! video/x-raw, format=" + hub_video_format;
+
+    // Never let the consumers hold back the camera.
+    pipeline_desc += " ! queue leaky=downstream max-size-buffers=2 max-size-bytes=0 "
+                     "max-size-time=0";
+
+    uint32_t frameSize = hubFormat_.width * hubFormat_.height * 3 / 2;
+    pipeline_desc += " ! shmsink name=hubSink socket-path=" + hubSocketPath_ +
+                     " shm-size=" + std::to_string(frameSize * kHubShmFrames) +
+                     " buffer-time=1000000000 wait-for-connection=false sync=false async=false";
+
+    LOGI("pipeline : %s", pipeline_desc.c_str());
+
+    pipeline_ = gst_parse_launch(pipeline_desc.c_str(), NULL);
+    if (pipeline_ == NULL)
+    {
+        LOGI("Error. Pipeline is NULL");
+        return false;
+    }
+
+    LOGI("end");
+    return true;
+}
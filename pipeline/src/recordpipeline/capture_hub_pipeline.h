@@ -0,0 +1,18 @@
+#ifndef CAPTURE_HUB_PIPELINE_H_
+#define CAPTURE_HUB_PIPELINE_H_
+
+#include "base_record_pipeline.h"
+
+/**
+ * Reads one camera once and republishes the converted frames on a shmsink socket.
+ * Every recording and snapshot of that camera attaches to the socket with its own
+ * shmsrc and leaky queue, so frames are shared by reference through the shm area.
+ */
+class CaptureHubPipeline : public BaseRecordPipeline
+{
+public:
+    CaptureHubPipeline() { pipelineType = "CaptureHub"; }
+    bool launch() override;
+};
+
+#endif // CAPTURE_HUB_PIPELINE_H_
@@ -0,0 +1,132 @@
+#include "rate_controller.h"
+#include "glog.h"
+#include <algorithm>
+
+// queue fill above which the stage behind it is considered congested
+static const double kHighWatermark = 0.75;
+// queue fill below which the pipeline is considered calm
+static const double kLowWatermark = 0.25;
+// samples to wait after a change before stepping down again
+static const uint32_t kHoldTicks = 2;
+// calm samples required before stepping up
+static const uint32_t kRecoverTicks = 5;
+// samples the sink has to write slower than the encoder before it counts as congested
+static const uint32_t kSlowSinkTicks = 3;
+
+void RateController::configure(uint32_t maxBitRate, uint32_t minBitRate, uint32_t maxFps,
+                               uint32_t minFps)
+{
+    maxBitRate_ = maxBitRate;
+    minBitRate_ = std::min(minBitRate, maxBitRate);
+    maxFps_     = maxFps;
+    minFps_     = std::min(minFps, maxFps);
+    bitRate_    = maxBitRate_;
+    fps_        = maxFps_;
+
+    holdTicks_     = 0;
+    calmTicks_     = 0;
+    slowSinkTicks_ = 0;
+
+    enabled_ =
+        (minBitRate_ > 0 && minBitRate_ < maxBitRate_) || (minFps_ > 0 && minFps_ < maxFps_);
+    LOGI("enabled %d, bitrate %u..%u, fps %u..%u", enabled_, minBitRate_, maxBitRate_, minFps_,
+         maxFps_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    adaptations_.clear();
+}
+
+bool RateController::update(const sample_t &sample, uint64_t time)
+{
+    if (!enabled_)
+        return false;
+
+    // The sink includes audio and container overhead, so writing less than the encoder
+    // produced for several samples in a row means the storage cannot keep up.
+    if (sample.encoded > 0 && sample.written < sample.encoded)
+        slowSinkTicks_++;
+    else
+        slowSinkTicks_ = 0;
+
+    const char *reason = nullptr;
+    if (sample.dropped > 0)
+        reason = "qos";
+    else if (sample.encoderFill >= kHighWatermark)
+        reason = "encoder";
+    else if (sample.muxFill >= kHighWatermark || slowSinkTicks_ >= kSlowSinkTicks)
+        reason = "sink";
+
+    if (holdTicks_ > 0)
+        holdTicks_--;
+
+    if (reason != nullptr)
+    {
+        calmTicks_ = 0;
+        if (holdTicks_ > 0 || !stepDown())
+            return false;
+
+        holdTicks_     = kHoldTicks;
+        slowSinkTicks_ = 0;
+        addAdaptation(time, reason);
+        return true;
+    }
+
+    if (sample.encoderFill > kLowWatermark || sample.muxFill > kLowWatermark)
+    {
+        calmTicks_ = 0;
+        return false;
+    }
+
+    if (++calmTicks_ < kRecoverTicks || !stepUp())
+        return false;
+
+    calmTicks_ = 0;
+    addAdaptation(time, "recovered");
+    return true;
+}
+
+bool RateController::stepDown()
+{
+    if (bitRate_ > minBitRate_ && minBitRate_ > 0)
+    {
+        bitRate_ = std::max(minBitRate_, bitRate_ / 4 * 3);
+        return true;
+    }
+    if (fps_ > minFps_ && minFps_ > 0)
+    {
+        fps_ = std::max(minFps_, fps_ / 4 * 3);
+        return true;
+    }
+    return false;
+}
+
+bool RateController::stepUp()
+{
+    if (fps_ < maxFps_)
+    {
+        fps_ = std::min(maxFps_, fps_ + std::max(1u, fps_ / 3));
+        return true;
+    }
+    if (bitRate_ < maxBitRate_)
+    {
+        bitRate_ = std::min(maxBitRate_, bitRate_ / 4 * 5);
+        return true;
+    }
+    return false;
+}
+
+void RateController::addAdaptation(uint64_t time, const char *reason)
+{
+    LOGI("%s : bitrate %u, fps %u", reason, bitRate_, fps_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (adaptations_.size() >= kMaxAdaptations)
+        adaptations_.erase(adaptations_.begin());
+    adaptations_.push_back({time, reason, bitRate_, fps_});
+}
+
+std::vector<base::rate_adaptation_t> RateController::getAdaptations()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return adaptations_;
+}
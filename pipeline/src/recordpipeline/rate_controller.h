@@ -0,0 +1,58 @@
+#ifndef RATE_CONTROLLER_H_
+#define RATE_CONTROLLER_H_
+
+#include "base.h"
+#include <mutex>
+#include <vector>
+
+/**
+ * Decides the video bitrate and framerate of a recording from congestion signals.
+ * Steps down the bitrate first and then the framerate while the pipeline is congested,
+ * and steps back up in the reverse order once it has been calm for a while.
+ */
+class RateController
+{
+public:
+    struct sample_t
+    {
+        uint64_t dropped;   // frames dropped by QoS since the last sample
+        double encoderFill; // 0..1, queue in front of the encoder
+        double muxFill;     // 0..1, queue in front of the muxer
+        uint64_t encoded;   // bytes produced by the encoder since the last sample
+        uint64_t written;   // bytes written by the sink since the last sample
+    };
+
+    void configure(uint32_t maxBitRate, uint32_t minBitRate, uint32_t maxFps, uint32_t minFps);
+    bool isEnabled() const { return enabled_; }
+
+    // Returns true when the bitrate or the framerate has to be changed.
+    bool update(const sample_t &sample, uint64_t time);
+
+    uint32_t getBitRate() const { return bitRate_; }
+    uint32_t getFps() const { return fps_; }
+    std::vector<base::rate_adaptation_t> getAdaptations();
+
+private:
+    static const size_t kMaxAdaptations = 64;
+
+    bool enabled_{false};
+    uint32_t maxBitRate_{0};
+    uint32_t minBitRate_{0};
+    uint32_t maxFps_{0};
+    uint32_t minFps_{0};
+    uint32_t bitRate_{0};
+    uint32_t fps_{0};
+
+    uint32_t holdTicks_{0};
+    uint32_t calmTicks_{0};
+    uint32_t slowSinkTicks_{0};
+
+    std::mutex mutex_;
+    std::vector<base::rate_adaptation_t> adaptations_;
+
+    bool stepDown();
+    bool stepUp();
+    void addAdaptation(uint64_t time, const char *reason);
+};
+
+#endif // RATE_CONTROLLER_H_
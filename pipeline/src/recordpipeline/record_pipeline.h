@@ -5,17 +5,25 @@
 #include <gst/gst.h>
 #include <string>
 
+namespace base
+{
+struct pipeline_stats_t;
+}
+
 using CALLBACK_T =
     std::function<void(const gint type, const gint64 numValue, const gchar *strValue, void *udata)>;
 
 class RecordPipeline
 {
 public:
-    virtual bool Load(const std::string &msg)       = 0;
-    virtual bool Unload()                           = 0;
-    virtual bool Play()                             = 0;
-    virtual bool Pause()                            = 0;
-    virtual void RegisterCbFunction(CALLBACK_T cbf) = 0;
+    virtual bool Load(const std::string &msg)                 = 0;
+    virtual bool Unload()                                     = 0;
+    virtual bool Stop()                                       = 0;
+    virtual bool Play()                                       = 0;
+    virtual bool Pause()                                      = 0;
+    virtual void RegisterCbFunction(CALLBACK_T cbf)           = 0;
+    virtual bool GetStatistics(base::pipeline_stats_t &stats) = 0;
+    virtual bool RequestKeyFrame()                            = 0;
 };
 
 #endif // RECORD_PIPELINE_H_
@@ -18,11 +18,21 @@ bool SnapshotPipeline::launch()
     }
     else
     {
-        std::string socketPath = "/tmp/" + video_src_;
-        pipeline_desc          = "shmsrc socket-path=" + socketPath + " num-buffers=1";
-        pipeline_desc += " ! video/x-raw, width=" + std::to_string(mImageFormat.width) +
-                         ", height=" + std::to_string(mImageFormat.height) +
-                         ", format=RGB16, framerate=0/1";
+        if (!hubSocketPath_.empty())
+        {
+            pipeline_desc = "shmsrc socket-path=" + hubSocketPath_ + " num-buffers=1";
+            pipeline_desc += " ! video/x-raw, width=" + std::to_string(mImageFormat.width) +
+                             ", height=" + std::to_string(mImageFormat.height) +
+                             ", format=" + hub_video_format + ", framerate=0/1";
+        }
+        else
+        {
+            std::string socketPath = "/tmp/" + video_src_;
+            pipeline_desc          = "shmsrc socket-path=" + socketPath + " num-buffers=1";
+            pipeline_desc += " ! video/x-raw, width=" + std::to_string(mImageFormat.width) +
+                             ", height=" + std::to_string(mImageFormat.height) +
+                             ", format=RGB16, framerate=0/1";
+        }
 
         pipeline_desc += " ! videoconvert";
         std::string element =
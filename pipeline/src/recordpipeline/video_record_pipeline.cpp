@@ -1,6 +1,9 @@
 #include "video_record_pipeline.h"
 #include "element_factory.h"
 #include "glog.h"
+#include <algorithm>
+#include <unistd.h>
+#include <vector>
 
 bool VideoRecordPipeline::launch()
 {
@@ -16,67 +19,101 @@ bool VideoRecordPipeline::launch()
     }
     else
     {
-        std::string socketPath = "/tmp/" + video_src_;
-
-        pipeline_desc =
-            "shmsrc socket-path=" + socketPath + " is-live=true do-timestamp=true name=videoSrc";
-
-        pipeline_desc += " ! video/x-raw, width=" + std::to_string(mVideoFormat.width) +
-                         ", height=" + std::to_string(mVideoFormat.height) +
-                         ", format=RGB16, framerate=0/1, colorimetry=1:1:5:1";
-
         std::string element =
-            ElementFactory::GetPreferredElementName(pipelineType, "video-converter");
-        if (!element.empty())
-            pipeline_desc += " ! " + element;
+            ElementFactory::GetPreferredElementName(pipelineType, "video-encoder");
+        bool isJpeg = (element.find("jpeg") != std::string::npos);
 
-        element = ElementFactory::GetPreferredElementName(pipelineType, "video-encoder");
-        if (!element.empty())
+        if (!sharedEncoderPath_.empty())
         {
-            pipeline_desc += " ! " + element;
+            // Already encoded by the encoder hub shared with recordings of the same settings.
+            pipeline_desc = "shmsrc socket-path=" + sharedEncoderPath_ +
+                            " is-live=true do-timestamp=true name=videoSrc";
 
-            if (element == "v4l2h264enc")
+            if (isJpeg)
+                pipeline_desc += " ! image/jpeg ! jpegparse name=videoEncoder";
+            else
+                pipeline_desc += " ! video/x-h264, stream-format=byte-stream, alignment=au"
+                                 " ! h264parse name=videoEncoder";
+        }
+        else
+        {
+            if (!compositeSrcs_.empty())
             {
-                if (mVideoFormat.bitRate)
-                {
-                    pipeline_desc += " extra-controls=\"encode, video_bitrate=" +
-                                     std::to_string(mVideoFormat.bitRate) + ";\"";
-                }
+                pipeline_desc = GetCompositeDesc();
+            }
+            else if (!hubSocketPath_.empty())
+            {
+                // Frames come already converted from the capture hub. The queue is leaky so
+                // a slow encoder here only drops frames of this recording.
+                pipeline_desc = "shmsrc socket-path=" + hubSocketPath_ +
+                                " is-live=true do-timestamp=true name=videoSrc";
+
+                pipeline_desc += " ! video/x-raw, width=" + std::to_string(mVideoFormat.width) +
+                                 ", height=" + std::to_string(mVideoFormat.height) +
+                                 ", format=" + hub_video_format + ", framerate=0/1";
+
+                pipeline_desc += " ! queue name=encQueue leaky=downstream";
+            }
+            else
+            {
+                pipeline_desc = GetCameraSrcDesc(video_src_, mVideoFormat.width,
+                                                 mVideoFormat.height, "videoSrc");
 
-                pipeline_desc += " ! capsfilter name=videoEnc ! h264parse";
+                std::string converter =
+                    ElementFactory::GetPreferredElementName(pipelineType, "video-converter");
+                if (!converter.empty())
+                    pipeline_desc += " ! " + converter;
+
+                pipeline_desc += " ! queue name=encQueue";
             }
+
+            pipeline_desc += GetEncoderDesc(element, "");
         }
 
-        pipeline_desc += " ! queue ! qtmux name=mux";
-        pipeline_desc += " ! filesink sync=true location=" + path_;
+        if (!encoderHubPath_.empty())
+        {
+            // Publish the encoded stream to the recordings sharing this encoder.
+            // SPS/PPS go with every IDR so that a recording can start at any keyframe.
+            if (!isJpeg)
+                pipeline_desc += " ! h264parse config-interval=-1"
+                                 " ! video/x-h264, stream-format=byte-stream, alignment=au";
 
-        // for audio
-        if (!mAudioFormat.empty())
+            pipeline_desc += " ! queue leaky=downstream max-size-buffers=0 max-size-bytes=0 "
+                             "max-size-time=1000000000";
+            pipeline_desc += " ! shmsink name=hubSink socket-path=" + encoderHubPath_ +
+                             " shm-size=" + std::to_string(kTapShmSize) +
+                             " buffer-time=1000000000 wait-for-connection=false sync=false "
+                             "async=false";
+        }
+        else
         {
-            pipeline_desc += " pulsesrc do_timestamp=false ! queue";
+            // Other consumers of the encoded stream branch off before the muxer.
+            std::vector<std::string> branches;
+            std::string branch = GetLiveOutputDesc(element);
+            if (!branch.empty())
+                branches.push_back(branch);
+            branch = GetEncodedTapDesc(element);
+            if (!branch.empty())
+                branches.push_back(branch);
 
-            std::string element =
-                ElementFactory::GetPreferredElementName(pipelineType, "audio-converter");
-            if (!element.empty())
-                pipeline_desc += " ! " + element + " ! capsfilter name=audioCaps";
-            else
-                pipeline_desc += " ! audioconvert ! capsfilter name=audioCaps";
+            if (!branches.empty())
+                pipeline_desc += " ! tee name=encTee";
 
-            if (mAudioFormat.codec == "AAC")
-            {
-                element =
-                    ElementFactory::GetPreferredElementName(pipelineType, "audio-encoder-aac");
-                if (!element.empty())
-                    pipeline_desc += " ! " + element + " name=audioEnc";
-                else
-                    pipeline_desc += " ! avenc_aac name=audioEnc";
-            }
-            else
+            pipeline_desc += " ! queue name=muxQueue ! qtmux name=mux";
+            pipeline_desc += " ! filesink name=videoSink sync=true location=" + path_;
+
+            for (const auto &desc : branches)
+                pipeline_desc += " encTee. ! " + desc;
+
+            // for audio
+            if (!mAudioFormat.empty())
             {
-                pipeline_desc += " ! avenc_aac name=audioEnc";
+                pipeline_desc += " " + GetAudioDesc() + " ! mux.";
             }
 
-            pipeline_desc += " ! mux.";
+            // other cameras of a multi-track recording, the first one is video_src_ above
+            for (size_t i = 1; i < trackSrcs_.size(); i++)
+                pipeline_desc += " " + GetTrackDesc(element, i);
         }
     }
 
@@ -89,48 +126,317 @@ bool VideoRecordPipeline::launch()
         return false;
     }
 
-    // 2. Setup encoder
-    auto caps_h264 = gst_bin_get_by_name(GST_BIN(pipeline_), "videoEnc");
-    if (caps_h264)
+    // 2. Setup encoder, one per track
+    for (size_t i = 0; i < std::max<size_t>(trackSrcs_.size(), 1); i++)
     {
-        auto caps = gst_caps_new_simple("video/x-h264", "level", G_TYPE_STRING, "4", nullptr);
+        std::string name = "videoEnc" + GetTrackSuffix(i);
+        auto caps_h264   = gst_bin_get_by_name(GST_BIN(pipeline_), name.c_str());
+        if (caps_h264)
+        {
+            auto caps = gst_caps_new_simple("video/x-h264", "level", G_TYPE_STRING, "4", nullptr);
 
-        g_object_set(caps_h264, "caps", caps, nullptr);
+            g_object_set(caps_h264, "caps", caps, nullptr);
+            gst_caps_unref(caps);
+            gst_object_unref(caps_h264);
+        }
     }
 
-    // 3. Setup audio capsfilter
-    auto audio_caps = gst_bin_get_by_name(GST_BIN(pipeline_), "audioCaps");
-    if (audio_caps)
+    // 3. Setup audio source, capsfilter and encoder
+    SetupAudio();
+
+    // 4. Setup pause, before the encoders or after the shared one
+    if (!sharedEncoderPath_.empty())
     {
-        auto caps = gst_caps_new_simple("audio/x-raw", "rate", G_TYPE_INT, mAudioFormat.sampleRate,
-                                        "channels", G_TYPE_INT, mAudioFormat.channels, nullptr);
-        g_object_set(audio_caps, "caps", caps, nullptr);
+        AddPauseGate("videoEncoder", true);
     }
-
-    // 4. Setup audio encoder
-    auto audio_enc = gst_bin_get_by_name(GST_BIN(pipeline_), "audioEnc");
-    if (audio_enc)
+    else
     {
-        g_object_set(audio_enc, "bitrate", mAudioFormat.bitRate, nullptr);
+        size_t count = std::max<size_t>({compositeSrcs_.size(), trackSrcs_.size(), 1});
+        for (size_t i = 0; i < count; i++)
+            AddPauseGate(("videoSrc" + GetTrackSuffix(i)).c_str(), false);
     }
 
+    // 5. Setup recording status
+    AddStatusProbes("videoEncoder", "videoSink");
+
+    // 6. Setup adaptive rate control, the shared encoder is not ours to adapt.
+    //    Tracks are started together instead, rate control handles a single encoder.
+    if (!sharedEncoderPath_.empty())
+        AddKeyFrameGate("videoEncoder");
+    else if (!trackSrcs_.empty())
+        AddTrackGates();
+    else
+        AddRateControl("videoEncoder", "encQueue", "muxQueue");
+
     LOGI("end");
     return true;
 }
 
-bool VideoRecordPipeline::Pause()
+void VideoRecordPipeline::AddKeyFrameGate(const char *parserName)
 {
-    LOGI("start");
+    GstElement *parser = gst_bin_get_by_name(GST_BIN(pipeline_), parserName);
+    if (parser == nullptr)
+        return;
 
-    bool ret = BaseRecordPipeline::Pause();
+    // A recording joining a shared encoder drops everything up to the next keyframe.
+    GstPad *pad = gst_element_get_static_pad(parser, "src");
+    if (pad)
+    {
+        gst_pad_add_probe(
+            pad, GST_PAD_PROBE_TYPE_BUFFER,
+            +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+            {
+                GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+                if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+                    return GST_PAD_PROBE_DROP;
 
-    // Reconfigure shmsrc
-    auto src = gst_bin_get_by_name(GST_BIN(pipeline_), "videoSrc");
-    gst_element_set_state(src, GST_STATE_PAUSED);
+                LOGI("first keyframe, start recording");
+                return GST_PAD_PROBE_REMOVE;
+            },
+            nullptr, nullptr);
+        gst_object_unref(pad);
+    }
+    gst_object_unref(parser);
+}
 
-    gst_element_set_state(src, GST_STATE_NULL);
-    gst_element_set_state(src, GST_STATE_PAUSED);
+std::string VideoRecordPipeline::GetTrackSuffix(size_t track)
+{
+    return (track == 0) ? "" : std::to_string(track);
+}
 
-    LOGI("end");
-    return ret;
+std::string VideoRecordPipeline::GetCameraSrcDesc(const std::string &videoSrc, uint32_t width,
+                                                  uint32_t height, const std::string &name)
+{
+    std::string desc =
+        "shmsrc socket-path=/tmp/" + videoSrc + " is-live=true do-timestamp=true name=" + name;
+
+    desc += " ! video/x-raw, width=" + std::to_string(width) +
+            ", height=" + std::to_string(height) +
+            ", format=RGB16, framerate=0/1, colorimetry=1:1:5:1";
+
+    return desc;
+}
+
+std::string VideoRecordPipeline::GetEncoderDesc(const std::string &encoder,
+                                                const std::string &suffix)
+{
+    if (encoder.empty())
+        return "";
+
+    std::string desc = " ! " + encoder + " name=videoEncoder" + suffix;
+
+    if (encoder == "v4l2h264enc")
+    {
+        if (mVideoFormat.bitRate)
+        {
+            desc += " extra-controls=\"encode, video_bitrate=" +
+                    std::to_string(mVideoFormat.bitRate) + ";\"";
+        }
+
+        desc += " ! capsfilter name=videoEnc" + suffix + " ! h264parse";
+    }
+
+    return desc;
+}
+
+std::string VideoRecordPipeline::GetTrackDesc(const std::string &encoder, size_t track)
+{
+    const composite_src_t &src = trackSrcs_[track];
+    std::string suffix         = GetTrackSuffix(track);
+
+    // Same chain as the first track, into a track of its own in the shared muxer.
+    // Sources timestamp on the pipeline clock, so the tracks share one timeline.
+    std::string desc = GetCameraSrcDesc(src.videoSrc, src.width, src.height, "videoSrc" + suffix);
+
+    std::string converter =
+        ElementFactory::GetPreferredElementName(pipelineType, "video-converter");
+    if (!converter.empty())
+        desc += " ! " + converter;
+
+    desc += " ! queue name=encQueue" + suffix;
+    desc += GetEncoderDesc(encoder, suffix);
+    desc += " ! queue ! mux.";
+
+    return desc;
+}
+
+void VideoRecordPipeline::AddTrackGates()
+{
+    {
+        std::lock_guard<std::mutex> lock(trackMutex_);
+        trackFirstPts_.assign(trackSrcs_.size(), GST_CLOCK_TIME_NONE);
+        trackStart_ = GST_CLOCK_TIME_NONE;
+    }
+
+    for (size_t i = 0; i < trackSrcs_.size(); i++)
+    {
+        std::string name = "encQueue" + GetTrackSuffix(i);
+        GstElement *queue = gst_bin_get_by_name(GST_BIN(pipeline_), name.c_str());
+        if (queue == nullptr)
+            continue;
+
+        GstPad *pad = gst_element_get_static_pad(queue, "sink");
+        if (pad)
+        {
+            gst_pad_add_probe(
+                pad, GST_PAD_PROBE_TYPE_BUFFER,
+                +[](GstPad *pad, GstPadProbeInfo *info, gpointer data) -> GstPadProbeReturn
+                {
+                    auto *gate = static_cast<track_gate_t *>(data);
+                    return gate->pipeline->passTrack(gate->track, GST_PAD_PROBE_INFO_BUFFER(info))
+                               ? GST_PAD_PROBE_REMOVE
+                               : GST_PAD_PROBE_DROP;
+                },
+                new track_gate_t{this, i},
+                +[](gpointer data) { delete static_cast<track_gate_t *>(data); });
+            gst_object_unref(pad);
+        }
+        gst_object_unref(queue);
+    }
+}
+
+bool VideoRecordPipeline::passTrack(size_t track, GstBuffer *buffer)
+{
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    if (!GST_CLOCK_TIME_IS_VALID(pts))
+        return false;
+
+    // Every track waits for the others to deliver a frame, then starts with its first frame
+    // at or after the latest of those. Track starts are thus within one frame of each other.
+    std::lock_guard<std::mutex> lock(trackMutex_);
+    if (!GST_CLOCK_TIME_IS_VALID(trackFirstPts_[track]))
+        trackFirstPts_[track] = pts;
+
+    if (!GST_CLOCK_TIME_IS_VALID(trackStart_))
+    {
+        for (GstClockTime first : trackFirstPts_)
+        {
+            if (!GST_CLOCK_TIME_IS_VALID(first))
+                return false;
+        }
+        trackStart_ = *std::max_element(trackFirstPts_.begin(), trackFirstPts_.end());
+        LOGI("tracks start at %" GST_TIME_FORMAT, GST_TIME_ARGS(trackStart_));
+    }
+
+    if (pts < trackStart_)
+        return false;
+
+    LOGI("track %zu starts at %" GST_TIME_FORMAT, track, GST_TIME_ARGS(pts));
+    return true;
+}
+
+std::string VideoRecordPipeline::GetCompositeDesc()
+{
+    // Each camera is scaled to its region before the compositor, on the hardware scaler of the
+    // platform when there is one, otherwise by videoscale/videoconvert (ORC SIMD). Scaling
+    // before the conversion keeps the conversion at the size of the region.
+    std::string scaler = ElementFactory::GetPreferredElementName(pipelineType, "video-scaler");
+    if (scaler.empty())
+        scaler = "videoscale ! videoconvert";
+
+    std::string desc;
+    std::string compositor = "compositor name=comp background=black";
+    for (size_t i = 0; i < compositeSrcs_.size(); i++)
+    {
+        const composite_src_t &src = compositeSrcs_[i];
+        std::string sink           = "sink_" + std::to_string(i);
+
+        desc += GetCameraSrcDesc(src.videoSrc, src.width, src.height,
+                                 "videoSrc" + GetTrackSuffix(i));
+        desc += " ! " + scaler + " ! video/x-raw, width=" + std::to_string(src.outWidth) +
+                ", height=" + std::to_string(src.outHeight) + ", format=" + hub_video_format;
+
+        // A camera that stalls must not hold back the others
+        desc += " ! queue leaky=downstream max-size-buffers=2 ! comp." + sink + " ";
+
+        compositor += " " + sink + "::xpos=" + std::to_string(src.x) + " " + sink +
+                      "::ypos=" + std::to_string(src.y) + " " + sink +
+                      "::zorder=" + std::to_string(i);
+    }
+
+    uint32_t fps = mVideoFormat.fps ? mVideoFormat.fps : 30;
+    desc += compositor;
+    desc += " ! video/x-raw, width=" + std::to_string(mVideoFormat.width) +
+            ", height=" + std::to_string(mVideoFormat.height) + ", format=" + hub_video_format +
+            ", framerate=" + std::to_string(fps) + "/1";
+    desc += " ! queue name=encQueue";
+
+    return desc;
+}
+
+std::string VideoRecordPipeline::GetLiveOutputDesc(const std::string &encoder)
+{
+    if (liveType_.empty())
+        return "";
+
+    // The live branch drops old data rather than holding back the recording.
+    std::string desc = "queue name=liveQueue leaky=downstream max-size-buffers=0 "
+                       "max-size-bytes=0 max-size-time=1000000000";
+    bool isJpeg      = (encoder.find("jpeg") != std::string::npos);
+
+    if (liveType_ == "rtp")
+    {
+        if (isJpeg)
+            desc += " ! rtpjpegpay";
+        else
+            desc += " ! h264parse config-interval=-1 ! rtph264pay config-interval=-1 pt=96";
+
+        desc += " ! udpsink name=liveSink host=127.0.0.1 port=" + std::to_string(livePort_) +
+                " sync=false async=false";
+    }
+    else if (liveType_ == "hls")
+    {
+        if (isJpeg)
+        {
+            LOGE("HLS needs H.264, %s is not supported", encoder.c_str());
+            return "";
+        }
+
+        std::string dir = livePath_;
+        if (dir.empty() || dir.back() != '/')
+            dir += "/";
+
+        if (g_mkdir_with_parents(dir.c_str(), 0755) != 0)
+        {
+            LOGE("Failed to create %s", dir.c_str());
+            return "";
+        }
+
+        desc += " ! h264parse ! hlssink2 name=liveSink location=" + dir +
+                "segment%05d.ts playlist-location=" + dir +
+                "playlist.m3u8 target-duration=2 max-files=5";
+    }
+    else
+    {
+        LOGE("Unsupported live output : %s", liveType_.c_str());
+        return "";
+    }
+
+    LOGI("live output : %s", desc.c_str());
+    return desc;
+}
+
+std::string VideoRecordPipeline::GetEncodedTapDesc(const std::string &encoder)
+{
+    if (tapSocketPath_.empty())
+        return "";
+
+    // A stale socket from a previous run would make shmsink fail to bind.
+    unlink(tapSocketPath_.c_str());
+
+    std::string desc = "queue name=tapQueue leaky=downstream max-size-buffers=0 "
+                       "max-size-bytes=0 max-size-time=1000000000";
+    if (encoder.find("jpeg") == std::string::npos)
+        desc += " ! h264parse config-interval=-1"
+                " ! video/x-h264, stream-format=byte-stream, alignment=au";
+
+    // gdppay keeps caps, timestamps and keyframe flags of every access unit.
+    // Consumers read with "shmsrc ! gdpdepay". Blocks a consumer still holds after
+    // buffer-time are reclaimed, so a slow consumer loses data instead of stalling us.
+    desc += " ! gdppay ! shmsink name=tapSink socket-path=" + tapSocketPath_ +
+            " shm-size=" + std::to_string(kTapShmSize) +
+            " buffer-time=1000000000 wait-for-connection=false sync=false async=false";
+
+    LOGI("encoded tap : %s", desc.c_str());
+    return desc;
 }
@@ -2,13 +2,39 @@
 #define VIDEO_RECORD_PIPELINE_H_
 
 #include "base_record_pipeline.h"
+#include <mutex>
+#include <vector>
 
 class VideoRecordPipeline : public BaseRecordPipeline
 {
+    static const uint32_t kTapShmSize = 8 * 1024 * 1024;
+
+    struct track_gate_t
+    {
+        VideoRecordPipeline *pipeline;
+        size_t track;
+    };
+
+    // start alignment of multi-track recordings
+    std::mutex trackMutex_;
+    std::vector<GstClockTime> trackFirstPts_;
+    GstClockTime trackStart_{GST_CLOCK_TIME_NONE};
+
+    std::string GetTrackSuffix(size_t track);
+    std::string GetCameraSrcDesc(const std::string &videoSrc, uint32_t width, uint32_t height,
+                                 const std::string &name);
+    std::string GetEncoderDesc(const std::string &encoder, const std::string &suffix);
+    std::string GetTrackDesc(const std::string &encoder, size_t track);
+    void AddTrackGates();
+    bool passTrack(size_t track, GstBuffer *buffer);
+    std::string GetCompositeDesc();
+    std::string GetLiveOutputDesc(const std::string &encoder);
+    std::string GetEncodedTapDesc(const std::string &encoder);
+    void AddKeyFrameGate(const char *parserName);
+
 public:
     VideoRecordPipeline() { pipelineType = "VideoRecord"; }
     bool launch() override;
-    bool Pause() override;
 };
 
 #endif // VIDEO_RECORD_PIPELINE_H_
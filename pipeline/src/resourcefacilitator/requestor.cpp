@@ -96,14 +96,46 @@ bool ResourceRequestor::acquireResources(PortResource_t &resourceMMap,
                                          const int32_t display_path)
 {
 
-    mrc::ResourceListOptions finalOptions;
-
     if (!setSourceInfo(sourceInfo))
     {
         LOGI("Failed to set source info!");
         return false;
     }
 
+    string payload;
+    string response;
+    if (!calcResourcePlan(display_mode, display_path, payload))
+        return false;
+
+    LOGI("send acquire to uMediaServer payload:%s", payload.c_str());
+
+    if (!umsRMC_->acquire(payload, response))
+    {
+        LOGI("fail to acquire!!! response : %s", response.c_str());
+        return false;
+    }
+    LOGI("acquire response:%s", response.c_str());
+
+    try
+    {
+        parsePortInformation(response, resourceMMap);
+        parseResources(response, acquiredResource_);
+    }
+    catch (const std::runtime_error &err)
+    {
+        LOGI("[%s:%d] err=%s, response:%s", __func__, __LINE__, err.what(), response.c_str());
+        return false;
+    }
+
+    LOGI("acquired Resource : %s", acquiredResource_.c_str());
+    return true;
+}
+
+bool ResourceRequestor::calcResourcePlan(const std::string &display_mode,
+                                         const int32_t display_path, std::string &payload)
+{
+    mrc::ResourceListOptions finalOptions;
+
     mrc::ResourceListOptions VResource = calcVdecResources();
     if (!VResource.empty())
     {
@@ -130,8 +162,6 @@ bool ResourceRequestor::acquireResources(PortResource_t &resourceMMap,
 
     JSchemaFragment input_schema("{}");
     JGenerator serializer(nullptr);
-    string payload;
-    string response;
 
     JValue objArray = pbnjson::Array();
     for (const auto &option : finalOptions)
@@ -152,27 +182,6 @@ bool ResourceRequestor::acquireResources(PortResource_t &resourceMMap,
         return false;
     }
 
-    LOGI("send acquire to uMediaServer payload:%s", payload.c_str());
-
-    if (!umsRMC_->acquire(payload, response))
-    {
-        LOGI("fail to acquire!!! response : %s", response.c_str());
-        return false;
-    }
-    LOGI("acquire response:%s", response.c_str());
-
-    try
-    {
-        parsePortInformation(response, resourceMMap);
-        parseResources(response, acquiredResource_);
-    }
-    catch (const std::runtime_error &err)
-    {
-        LOGI("[%s:%d] err=%s, response:%s", __func__, __LINE__, err.what(), response.c_str());
-        return false;
-    }
-
-    LOGI("acquired Resource : %s", acquiredResource_.c_str());
     return true;
 }
 
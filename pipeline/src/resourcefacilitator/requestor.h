@@ -83,6 +83,8 @@ public:
     const std::string getAcquiredResource() const { return acquiredResource_; }
 
 private:
+    bool calcResourcePlan(const std::string &display_mode, const int32_t display_path,
+                          std::string &payload);
     bool setSourceInfo(const base::source_info_t &sourceInfo);
     bool policyActionHandler(const char *action, const char *resources, const char *requestorType,
                              const char *requestorName, const char *connectionId);
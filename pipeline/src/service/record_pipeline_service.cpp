@@ -16,11 +16,16 @@
 
 #define LOG_TAG "RecordPipelineService"
 #include "record_pipeline_service.h"
+#include "flight_recorder.h"
 #include "glog.h"
+#include <cstdlib>
+#include <glib-unix.h>
 #include <pbnjson.hpp>
 #include <string>
+#include <unistd.h>
 
 #include "base.h"
+#include "base_record_pipeline.h"
 #include "camera_types.h"
 #include "message.h"
 #include "parser.h"
@@ -28,24 +33,16 @@
 #include "record_pipeline.h"
 #include "resourcefacilitator/requestor.h"
 #include "serializer.h"
+#include "startup_timer.h"
 
-const char *const SUBSCRIPTION_KEY = "RecordPipelineService";
-
-RecordPipelineService::RecordPipelineService(const char *service_name)
-    : LS::Handle(LS::registerService(service_name))
+RecordPipelineService::RecordPipelineService(int control_fd) : controlFd_(control_fd)
 {
-    LOGI("Start : %s", service_name);
-
-    LS_CATEGORY_BEGIN(RecordPipelineService, "/")
-    LS_CATEGORY_METHOD(start)
-    LS_CATEGORY_METHOD(stop)
-    LS_CATEGORY_METHOD(pause)
-    LS_CATEGORY_METHOD(resume)
-    LS_CATEGORY_METHOD(subscribe)
-    LS_CATEGORY_END;
+    LOGI("Start : control fd %d", control_fd);
 
-    // attach to mainloop and run it
-    attachToLoop(main_loop_ptr_.get());
+    // commands are served on the main loop
+    controlWatch_ = g_unix_fd_add(controlFd_, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR),
+                                  &RecordPipelineService::HandleControl, this);
+    StartupTimer::getInstance().mark("control channel");
 
     // run the gmainloop
     g_main_loop_run(main_loop_ptr_.get());
@@ -53,32 +50,163 @@ RecordPipelineService::RecordPipelineService(const char *service_name)
     LOGI("end");
 }
 
+RecordPipelineService::~RecordPipelineService()
+{
+    if (finalizeThread_.joinable())
+        finalizeThread_.join();
+
+    if (controlWatch_)
+        g_source_remove(controlWatch_);
+    close(controlFd_);
+}
+
+gboolean RecordPipelineService::HandleControl(gint fd, GIOCondition condition, gpointer data)
+{
+    auto *service = static_cast<RecordPipelineService *>(data);
+
+    control::header_t request;
+    std::string payload;
+    if (!(condition & G_IO_IN) || !control::receive(fd, request, payload))
+    {
+        service->controlWatch_ = 0;
+        service->HandleClose();
+        return G_SOURCE_REMOVE;
+    }
+
+    if (request.type == control::REQUEST)
+        service->HandleRequest(request, payload);
+    else
+        LOGE("unexpected message type %u", request.type);
+
+    return G_SOURCE_CONTINUE;
+}
+
+void RecordPipelineService::HandleRequest(const control::header_t &request,
+                                          const std::string &payload)
+{
+    bool ret = false;
+    std::string reply;
+    switch (request.code)
+    {
+    case control::CMD_START:
+        ret = start(payload);
+        break;
+    case control::CMD_STOP:
+        ret = stop();
+        break;
+    case control::CMD_PAUSE:
+        ret = pause();
+        break;
+    case control::CMD_RESUME:
+        ret = resume();
+        break;
+    case control::CMD_GET_STATISTICS:
+        ret = getStatistics(reply);
+        break;
+    case control::CMD_REQUEST_KEY_FRAME:
+        ret = requestKeyFrame();
+        break;
+    default:
+        LOGE("unknown command %u", request.code);
+        break;
+    }
+    LOGI("command %u : %s", request.code, ret ? "ok" : "failed");
+    flight::record(flight::EV_COMMAND, request.code, ret ? 0 : -1, "pipeline");
+
+    control::header_t header{};
+    header.type   = control::REPLY;
+    header.code   = request.code;
+    header.seq    = request.seq;
+    header.result = ret ? 0 : -1;
+    header.length = reply.size();
+    if (!control::send(controlFd_, header, reply.data()))
+        LOGE("fails to reply to %u : %d", request.code, errno);
+}
+
+void RecordPipelineService::HandleClose()
+{
+    // The service went away. A recording is still finalized, so that its file stays
+    // playable, and the main loop quits once it is unloaded.
+    LOGI("control channel closed");
+    controlClosed_ = true;
+    if (isLoaded_ && recorder_)
+    {
+        if (stop())
+            return;
+
+        // nothing to finalize in the background, unload what there is and leave
+        isLoaded_ = false;
+        Finalize();
+    }
+    if (!finalizeThread_.joinable())
+        g_main_loop_quit(main_loop_ptr_.get());
+}
+
+bool RecordPipelineService::Send(uint16_t event, int32_t result, const void *payload,
+                                 uint32_t length)
+{
+    control::header_t header{};
+    header.type   = control::NOTIFY;
+    header.code   = event;
+    header.result = result;
+    header.length = length;
+    flight::record(flight::EV_NOTIFY, event, result, "pipeline");
+    return control::send(controlFd_, header, payload);
+}
+
+template <typename T>
+void RecordPipelineService::NotifyJson(const char *key, const T &value)
+{
+    if (controlClosed_)
+        return;
+
+    // one per thread, the buffer is reused from one notification to the next
+    static thread_local parser::Composer composer;
+    composer.clear();
+    composer.put(key, value);
+
+    const std::string &result = composer.result();
+    LOGI("%s", result.c_str());
+    Send(control::EVT_JSON, 0, result.data(), result.size());
+}
+
 void RecordPipelineService::Notify(const gint notification, const gint64 numValue,
                                    const gchar *strValue, void *payload)
 {
-    parser::Composer composer;
-    base::media_info_t mediaInfo = {media_id_};
     switch (notification)
     {
     case GRP_NOTIFY_SOURCE_INFO:
     {
-        base::source_info_t info = *static_cast<base::source_info_t *>(payload);
-        composer.put("sourceInfo", info);
+        NotifyJson("sourceInfo", *static_cast<const base::source_info_t *>(payload));
         break;
     }
 
     case GRP_NOTIFY_VIDEO_INFO:
     {
-        base::video_info_t info = *static_cast<base::video_info_t *>(payload);
-        composer.put("videoInfo", info);
-        LOGI("videoInfo: width %d, height %d", info.width, info.height);
+        const auto *info = static_cast<const base::video_info_t *>(payload);
+        LOGI("videoInfo: width %d, height %d", info->width, info->height);
+        NotifyJson("videoInfo", *info);
+        break;
+    }
+    case GRP_NOTIFY_RECORDING_STATUS:
+    {
+        const auto *status = static_cast<base::recording_status_t *>(payload);
+        control::recording_status_t msg{status->duration, status->bytes,  status->bitrate,
+                                        status->fps,      status->frames, status->dropped};
+        Send(control::EVT_RECORDING_STATUS, 0, &msg, sizeof(msg));
+        break;
+    }
+    case GRP_NOTIFY_STARTUP_TIMING:
+    {
+        NotifyJson("startupTiming", *static_cast<const base::startup_timing_t *>(payload));
         break;
     }
     case GRP_NOTIFY_ERROR:
     {
-        base::error_t error = *static_cast<base::error_t *>(payload);
-        error.mediaId       = media_id_;
-        composer.put("error", error);
+        const auto *error = static_cast<base::error_t *>(payload);
+        LOGE("error %d : %s", error->errorCode, error->errorText.c_str());
+        Send(control::EVT_ERROR, error->errorCode, error->errorText.data(),
+             error->errorText.size());
 
         if (numValue == GRP_ERROR_RES_ALLOC)
         {
@@ -86,15 +214,26 @@ void RecordPipelineService::Notify(const gint notification, const gint64 numValu
         }
         break;
     }
+    case GRP_NOTIFY_FINALIZED:
+    {
+        // fixed part, then the path
+        const auto *finalized = static_cast<base::finalized_t *>(payload);
+        control::finalized_t msg{finalized->duration, finalized->size};
+        std::string data(reinterpret_cast<const char *>(&msg), sizeof(msg));
+        data += finalized->path;
+        LOGI("finalized %s", finalized->path.c_str());
+        Send(control::EVT_FINALIZED, 0, data.data(), data.size());
+        break;
+    }
     case GRP_NOTIFY_LOAD_COMPLETED:
     {
-        composer.put("loadCompleted", mediaInfo);
+        Send(control::EVT_LOAD_COMPLETED);
         break;
     }
 
     case GRP_NOTIFY_UNLOAD_COMPLETED:
     {
-        composer.put("unloadCompleted", mediaInfo);
+        Send(control::EVT_UNLOAD_COMPLETED);
         LOGI("quit main loop");
         g_main_loop_quit(main_loop_ptr_.get());
         break;
@@ -102,26 +241,26 @@ void RecordPipelineService::Notify(const gint notification, const gint64 numValu
 
     case GRP_NOTIFY_END_OF_STREAM:
     {
-        composer.put("endOfStream", mediaInfo);
+        Send(control::EVT_END_OF_STREAM);
         break;
     }
 
     case GRP_NOTIFY_PLAYING:
     {
-        composer.put("playing", mediaInfo);
+        Send(control::EVT_PLAYING);
         break;
     }
 
     case GRP_NOTIFY_PAUSED:
     {
-        composer.put("paused", mediaInfo);
+        Send(control::EVT_PAUSED);
         break;
     }
     case GRP_NOTIFY_ACTIVITY:
     {
         LOGI("notifyActivity to resource requestor");
-        if (resourceRequestor_)
-            resourceRequestor_->notifyActivity();
+        if (getRequestor())
+            getRequestor()->notifyActivity();
         break;
     }
     case GRP_NOTIFY_ACQUIRE_RESOURCE:
@@ -131,49 +270,45 @@ void RecordPipelineService::Notify(const gint notification, const gint64 numValu
         info->result = AcquireResources(*(info->sourceInfo), info->displayMode, numValue);
         break;
     }
+    case GRP_NOTIFY_RELEASE_RESOURCE:
+    {
+        LOGI("Notify, GRP_NOTIFY_RELEASE_RESOURCE");
+        if (getRequestor())
+            getRequestor()->releaseResource();
+        break;
+    }
     default:
     {
         LOGI("This notification(%d) can't be handled here!", notification);
         break;
     }
     }
-
-    if (!composer.result().empty())
-    {
-        LOGI("%s", composer.result().c_str());
-
-        unsigned int num_subscribers =
-            LSSubscriptionGetHandleSubscribersCount(this->get(), SUBSCRIPTION_KEY);
-        if (num_subscribers > 0)
-        {
-            LOGI("num_subscribers = %u", num_subscribers);
-
-            LSError lserror;
-            LSErrorInit(&lserror);
-
-            LOGI("notifying");
-            if (!LSSubscriptionReply(this->get(), SUBSCRIPTION_KEY, composer.result().c_str(),
-                                     &lserror))
-            {
-                LSErrorPrint(&lserror, stderr);
-                LOGE("subscription reply failed");
-            }
-            LSErrorFree(&lserror);
-        }
-    }
 }
 
-bool RecordPipelineService::start(LSMessage &message)
+bool RecordPipelineService::start(const std::string &payload)
 {
-    jvalue_ref json_outobj = jobject_create();
-    auto *payload          = LSMessageGetPayload(&message);
-    LOGI("payload %s", payload);
+    LOGI("payload %s", payload.c_str());
 
     pbnjson::JValue parsed = pbnjson::JDomParser::fromString(payload);
+    StartupTimer::getInstance().mark("start request");
 
-    app_id_            = "com.webos.app.mediaevents-test";
-    media_id_          = "";
-    resourceRequestor_ = std::make_unique<resource::ResourceRequestor>(app_id_, media_id_);
+    app_id_   = "com.webos.app.mediaevents-test";
+    media_id_ = "";
+
+    // the GST_* environment is set while this is still the only thread
+    BaseRecordPipeline::SetGstreamerDebug();
+
+    // registerPipeline is a round trip to uMS, it runs while the recorder is created and
+    // its pipeline built. getRequestor() waits for it.
+    if (BaseRecordPipeline::UseResourceManager())
+    {
+        requestorCreated_ =
+            std::async(std::launch::async, &RecordPipelineService::createRequestor, this).share();
+    }
+    else
+    {
+        LOGI("resource manager disabled");
+    }
 
     recorder_ = PipelineFactory::CreateRecorder(parsed);
 
@@ -196,127 +331,100 @@ bool RecordPipelineService::start(LSMessage &message)
         }
     }
 
-    jobject_put(json_outobj, J_CSTR_TO_JVAL("returnValue"), jboolean_create(true));
-
-    LS::Message request(&message);
-    request.respond(jvalue_stringify(json_outobj));
-    LOGI("response message : %s", jvalue_stringify(json_outobj));
-
-    j_release(&json_outobj);
-
-    return true;
+    return isLoaded_;
 }
 
-bool RecordPipelineService::stop(LSMessage &message)
+bool RecordPipelineService::stop()
 {
-    bool ret               = false;
-    jvalue_ref json_outobj = jobject_create();
-    auto *payload          = LSMessageGetPayload(&message);
-    LOGI("payload %s", payload);
-
     if (!isLoaded_)
     {
         LOGI("already unloaded");
-        ret = true;
+        return true;
     }
-    else
+
+    // Reply once capture has stopped, the file is finalized in the background
+    if (!recorder_ || !recorder_->Stop())
     {
-        if (!recorder_ || !recorder_->Unload())
-            LOGE("fails to unload the player");
-        else
-        {
-            isLoaded_ = false;
-            ret       = true;
-            if (resourceRequestor_)
-            {
-                resourceRequestor_->releaseResource();
-            }
-            else
-                LOGE("ReleaseResources fails");
-        }
+        LOGE("fails to stop the recorder");
+        return false;
     }
 
-    jobject_put(json_outobj, J_CSTR_TO_JVAL("returnValue"), jboolean_create(ret));
+    isLoaded_       = false;
+    finalizeThread_ = std::thread(&RecordPipelineService::Finalize, this);
+    return true;
+}
 
-    LS::Message request(&message);
-    request.respond(jvalue_stringify(json_outobj));
-    LOGI("response message : %s", jvalue_stringify(json_outobj));
+void RecordPipelineService::Finalize()
+{
+    LOGI("start");
 
-    j_release(&json_outobj);
+    // Ends with the finalized and unloadCompleted notifications, the latter quits the
+    // main loop and the process exits once this thread is joined.
+    if (!recorder_->Unload())
+        LOGE("fails to unload the player");
 
-    return true;
+    if (getRequestor())
+    {
+        getRequestor()->releaseResource();
+    }
+    else
+        LOGE("ReleaseResources fails");
+
+    LOGI("end");
 }
 
-bool RecordPipelineService::pause(LSMessage &message)
+bool RecordPipelineService::pause()
 {
-    jvalue_ref json_outobj = jobject_create();
-    auto *payload          = LSMessageGetPayload(&message);
-    LOGI("payload %s", payload);
-
     if (!recorder_ || !isLoaded_)
     {
         LOGE("Invalid recorder state, recorder should be loaded");
         return false;
     }
 
-    bool ret = recorder_->Pause();
-
-    jobject_put(json_outobj, J_CSTR_TO_JVAL("returnValue"), jboolean_create(ret));
-
-    LS::Message request(&message);
-    request.respond(jvalue_stringify(json_outobj));
-    LOGI("response message : %s", jvalue_stringify(json_outobj));
-
-    j_release(&json_outobj);
-
-    return true;
+    // The pipeline keeps PLAYING while paused, so the encoder stays in use
+    return recorder_->Pause();
 }
 
-bool RecordPipelineService::resume(LSMessage &message)
+bool RecordPipelineService::resume()
 {
-    jvalue_ref json_outobj = jobject_create();
-    auto *payload          = LSMessageGetPayload(&message);
-    LOGI("payload %s", payload);
-
     if (!recorder_ || !isLoaded_)
     {
         LOGE("Invalid recorder state, recorder should be loaded");
         return false;
     }
 
-    bool ret = recorder_->Play();
-
-    jobject_put(json_outobj, J_CSTR_TO_JVAL("returnValue"), jboolean_create(ret));
-
-    LS::Message request(&message);
-    request.respond(jvalue_stringify(json_outobj));
-    LOGI("response message : %s", jvalue_stringify(json_outobj));
+    return recorder_->Play();
+}
 
-    j_release(&json_outobj);
+bool RecordPipelineService::getStatistics(std::string &statistics)
+{
+    base::pipeline_stats_t stats = {};
+    if (!recorder_ || !isLoaded_)
+    {
+        LOGE("Invalid recorder state, recorder should be loaded");
+        return false;
+    }
+    if (!recorder_->GetStatistics(stats))
+    {
+        LOGE("Statistics are not enabled");
+        return false;
+    }
 
+    static thread_local parser::Composer composer;
+    composer.put(stats);
+    statistics = composer.result();
     return true;
 }
 
-bool RecordPipelineService::subscribe(LSMessage &message)
+bool RecordPipelineService::requestKeyFrame()
 {
-    LOGI("start");
-    LSError error;
-    LSErrorInit(&error);
-
-    bool ret = LSSubscriptionAdd(this->get(), SUBSCRIPTION_KEY, &message, &error);
-    LOGI("LSSubscriptionAdd %s", ret ? "ok" : "failed");
-    LOGI("cnt %d", LSSubscriptionGetHandleSubscribersCount(this->get(), SUBSCRIPTION_KEY));
-    LSErrorFree(&error);
-
-    jvalue_ref json_outobj = jobject_create();
-    jobject_put(json_outobj, J_CSTR_TO_JVAL("returnValue"), jboolean_create(ret));
-    LS::Message request(&message);
-    request.respond(jvalue_stringify(json_outobj));
-    LOGI("response message : %s", jvalue_stringify(json_outobj));
-
-    j_release(&json_outobj);
+    if (!recorder_ || !isLoaded_)
+    {
+        LOGE("Invalid recorder state, recorder should be loaded");
+        return false;
+    }
 
-    return ret;
+    return recorder_->RequestKeyFrame();
 }
 
 void RecordPipelineService::LoadCommon()
@@ -324,18 +432,29 @@ void RecordPipelineService::LoadCommon()
     recorder_->RegisterCbFunction(std::bind(&RecordPipelineService::Notify, this,
                                             std::placeholders::_1, std::placeholders::_2,
                                             std::placeholders::_3, std::placeholders::_4));
+}
 
-    if (resourceRequestor_)
-    {
-        resourceRequestor_->registerUMSPolicyActionCallback(
-            [this]()
-            {
-                base::error_t error;
-                error.errorCode = MEDIA_MSG_ERR_POLICY;
-                error.errorText = "Policy Action";
-                Notify(GRP_NOTIFY_ERROR, GRP_ERROR_RES_ALLOC, nullptr, static_cast<void *>(&error));
-            });
-    }
+resource::ResourceRequestor *RecordPipelineService::getRequestor()
+{
+    if (requestorCreated_.valid())
+        requestorCreated_.wait();
+    return resourceRequestor_.get();
+}
+
+void RecordPipelineService::createRequestor()
+{
+    gint64 start       = g_get_monotonic_time();
+    resourceRequestor_ = std::make_unique<resource::ResourceRequestor>(app_id_, media_id_);
+    StartupTimer::getInstance().add("ums registration", start);
+
+    resourceRequestor_->registerUMSPolicyActionCallback(
+        [this]()
+        {
+            base::error_t error;
+            error.errorCode = MEDIA_MSG_ERR_POLICY;
+            error.errorText = "Policy Action";
+            Notify(GRP_NOTIFY_ERROR, GRP_ERROR_RES_ALLOC, nullptr, static_cast<void *>(&error));
+        });
 }
 
 bool RecordPipelineService::AcquireResources(const base::source_info_t &sourceInfo,
@@ -344,10 +463,10 @@ bool RecordPipelineService::AcquireResources(const base::source_info_t &sourceIn
     LOGI("RecordPipelineService::AcquireResources");
     resource::PortResource_t resourceMMap;
 
-    if (resourceRequestor_)
+    if (getRequestor())
     {
-        if (!resourceRequestor_->acquireResources(resourceMMap, sourceInfo, display_mode,
-                                                  display_path))
+        if (!getRequestor()->acquireResources(resourceMMap, sourceInfo, display_mode,
+                                              display_path))
         {
             LOGE("resource acquisition failed");
             return false;
@@ -362,45 +481,47 @@ bool RecordPipelineService::AcquireResources(const base::source_info_t &sourceIn
     return true;
 }
 
-std::string parseRecordPipelineServiceName(int argc, char *argv[]) noexcept
+int parseControlFd(int argc, char *argv[]) noexcept
 {
     int c;
-    std::string serviceName;
+    int fd = -1;
 
-    while ((c = getopt(argc, argv, "s:")) != -1)
+    while ((c = getopt(argc, argv, "c:")) != -1)
     {
         switch (c)
         {
-        case 's':
-            serviceName = optarg ? optarg : "";
+        case 'c':
+            fd = optarg ? atoi(optarg) : -1;
             break;
 
         case '?':
-            LOGE("unknown service name");
+            LOGE("unknown option");
             break;
 
         default:
             break;
         }
     }
-    if (serviceName.empty())
+    if (fd < 0)
     {
-        LOGE("service name is not specified");
+        LOGE("control channel is not specified");
     }
-    return serviceName;
+    return fd;
 }
 
 int main(int argc, char *argv[])
 {
     LOGI("start");
+    StartupTimer::getInstance().mark("exec");
+    flight::scope_t flightRing("pipeline");
     try
     {
-        std::string serviceName = parseRecordPipelineServiceName(argc, argv);
-        if (serviceName.empty())
+        int controlFd = parseControlFd(argc, argv);
+        if (controlFd < 0)
         {
             return 1;
         }
-        RecordPipelineService RecordPipelineServiceInstance(serviceName.c_str());
+        RecordPipelineService RecordPipelineServiceInstance(controlFd);
     }
     catch (...)
     {
@@ -17,20 +17,26 @@
 #ifndef RECORD_SERVICE_H_
 #define RECORD_SERVICE_H_
 
-#include "luna-service2/lunaservice.hpp"
+#include "base.h"
+#include "control_protocol.h"
+#include <atomic>
+#include <future>
 #include <glib.h>
+#include <thread>
 
-namespace base
-{
-struct source_info_t;
-}
 namespace resource
 {
 class ResourceRequestor;
 }
 
 class RecordPipeline;
-class RecordPipelineService : public LS::Handle
+
+/**
+ * Serves the commands of the control channel inherited from the service, on the main loop.
+ * Notifications are sent on the same channel from whichever thread raises them, each
+ * message is a single packet so they do not interleave.
+ */
+class RecordPipelineService
 {
     using mainloop          = std::unique_ptr<GMainLoop, void (*)(GMainLoop *)>;
     mainloop main_loop_ptr_ = {g_main_loop_new(nullptr, false), g_main_loop_unref};
@@ -39,21 +45,36 @@ public:
     void Notify(const gint notification, const gint64 numValue, const gchar *strValue,
                 void *payload = nullptr);
 
-    RecordPipelineService(const char *service_name);
+    explicit RecordPipelineService(int control_fd);
+    ~RecordPipelineService();
 
     RecordPipelineService(RecordPipelineService const &)            = delete;
     RecordPipelineService(RecordPipelineService &&)                 = delete;
     RecordPipelineService &operator=(RecordPipelineService const &) = delete;
     RecordPipelineService &operator=(RecordPipelineService &&)      = delete;
 
-    bool start(LSMessage &message);
-    bool stop(LSMessage &message);
-    bool pause(LSMessage &message);
-    bool resume(LSMessage &message);
-    bool subscribe(LSMessage &message);
+    bool start(const std::string &payload);
+    bool stop();
+    bool pause();
+    bool resume();
+    bool getStatistics(std::string &statistics);
+    bool requestKeyFrame();
 
 private:
+    static gboolean HandleControl(gint fd, GIOCondition condition, gpointer data);
+    void HandleRequest(const control::header_t &request, const std::string &payload);
+    void HandleClose();
+    bool Send(uint16_t event, int32_t result = 0, const void *payload = nullptr,
+              uint32_t length = 0);
+
+    // Sends {key: value} as EVT_JSON, composed only while the service is there to read it.
+    template <typename T>
+    void NotifyJson(const char *key, const T &value);
+
     void LoadCommon();
+    void Finalize();
+    resource::ResourceRequestor *getRequestor();
+    void createRequestor();
     bool AcquireResources(const base::source_info_t &sourceInfo,
                           const std::string &display_mode = "Default", uint32_t display_path = 0);
 
@@ -61,9 +82,17 @@ private:
     std::string app_id_;
     std::shared_ptr<RecordPipeline> recorder_;
     std::unique_ptr<resource::ResourceRequestor> resourceRequestor_;
+    std::shared_future<void> requestorCreated_;
     bool isLoaded_ = false;
+
+    int controlFd_      = -1;
+    guint controlWatch_ = 0;
+    std::atomic<bool> controlClosed_{false};
+
+    // finalizes the file and releases the resources once stopped
+    std::thread finalizeThread_;
 };
 
-std::string parseRecordPipelineServiceName(int argc, char *argv[]) noexcept;
+int parseControlFd(int argc, char *argv[]) noexcept;
 
 #endif // RECORD_SERVICE_H_
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "startup_timer.h"
+#include "glog.h"
+#include <fstream>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+
+// Start time of this process in us since boot, from /proc/self/stat.
+static bool readProcessStartTime(gint64 &start)
+{
+    std::ifstream stat("/proc/self/stat");
+    std::string line;
+    if (!std::getline(stat, line))
+        return false;
+
+    // The command name may contain spaces, fields are counted after it.
+    size_t pos = line.rfind(')');
+    if (pos == std::string::npos)
+        return false;
+
+    std::istringstream fields(line.substr(pos + 1));
+    std::string field;
+    for (int i = 0; i < 20 && fields >> field; i++)
+        ;
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    if (fields.fail() || ticks <= 0)
+        return false;
+
+    start = std::stoll(field) * G_USEC_PER_SEC / ticks;
+    return true;
+}
+
+StartupTimer::StartupTimer()
+{
+    gint64 now = g_get_monotonic_time();
+    origin_    = now;
+
+    // The process start time is on the boot clock, the timeline is on the monotonic one.
+    gint64 start = 0;
+    struct timespec boot;
+    if (readProcessStartTime(start) && clock_gettime(CLOCK_BOOTTIME, &boot) == 0)
+    {
+        gint64 since_boot = boot.tv_sec * G_USEC_PER_SEC + boot.tv_nsec / 1000;
+        if (since_boot > start)
+            origin_ = now - (since_boot - start);
+    }
+    last_ = origin_;
+}
+
+StartupTimer &StartupTimer::getInstance()
+{
+    static StartupTimer instance;
+    return instance;
+}
+
+void StartupTimer::addEvent(const char *stage, gint64 start, gint64 end)
+{
+    base::timing_event_t event;
+    event.stage = stage;
+    event.start = (start > origin_) ? start - origin_ : 0;
+    event.end   = (end > origin_) ? end - origin_ : 0;
+    events_.push_back(event);
+
+    LOGI("startup %s : %" G_GUINT64_FORMAT " us (%" G_GUINT64_FORMAT " - %" G_GUINT64_FORMAT
+         " us)",
+         stage, event.end - event.start, event.start, event.end);
+}
+
+void StartupTimer::mark(const char *stage)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    gint64 now = g_get_monotonic_time();
+    addEvent(stage, last_, now);
+    last_ = now;
+}
+
+void StartupTimer::add(const char *stage, gint64 start)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    addEvent(stage, start, g_get_monotonic_time());
+}
+
+base::startup_timing_t StartupTimer::getTiming()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return base::startup_timing_t{events_};
+}
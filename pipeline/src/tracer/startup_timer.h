@@ -0,0 +1,53 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STARTUP_TIMER_H_
+#define STARTUP_TIMER_H_
+
+#include "base.h"
+#include <glib.h>
+#include <mutex>
+#include <vector>
+
+/**
+ * Timeline of the startup of this process, from exec to the first buffer written.
+ * Stages are in us since the process was started, so each event shows both
+ * where the time went and what ran concurrently.
+ */
+class StartupTimer
+{
+    std::mutex mutex_;
+    gint64 origin_{0}; // monotonic time the process was started at
+    gint64 last_{0};   // end of the previous stage of the startup sequence
+    std::vector<base::timing_event_t> events_;
+
+    StartupTimer();
+    void addEvent(const char *stage, gint64 start, gint64 end);
+
+public:
+    static StartupTimer &getInstance();
+
+    StartupTimer(StartupTimer const &)            = delete;
+    StartupTimer &operator=(StartupTimer const &) = delete;
+
+    // Records a stage of the startup sequence, from the end of the previous one until now.
+    void mark(const char *stage);
+    // Records a stage that ran next to the sequence, from start (monotonic) until now.
+    void add(const char *stage, gint64 start);
+    base::startup_timing_t getTiming();
+};
+
+#endif // STARTUP_TIMER_H_
@@ -0,0 +1,247 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stats_tracer.h"
+#include "glog.h"
+#include <fstream>
+#include <unistd.h>
+
+typedef struct
+{
+    GstTracer parent;
+} GrpStatsTracer;
+
+typedef struct
+{
+    GstTracerClass parent_class;
+} GrpStatsTracerClass;
+
+G_DEFINE_TYPE(GrpStatsTracer, grp_stats_tracer, GST_TYPE_TRACER)
+
+static void do_push_buffer_pre(GstTracer *self, GstClockTime ts, GstPad *pad, GstBuffer *buffer)
+{
+    StatsTracer::getInstance().onBufferPush(ts, pad, buffer);
+}
+
+static void do_push_buffer_list_pre(GstTracer *self, GstClockTime ts, GstPad *pad,
+                                    GstBufferList *list)
+{
+    StatsTracer::getInstance().onBufferListPush(ts, pad, list);
+}
+
+static void do_post_message_pre(GstTracer *self, GstClockTime ts, GstElement *element,
+                                GstMessage *message)
+{
+    StatsTracer::getInstance().onMessagePost(element, message);
+}
+
+static void grp_stats_tracer_class_init(GrpStatsTracerClass *klass) {}
+
+static void grp_stats_tracer_init(GrpStatsTracer *self)
+{
+    GstTracer *tracer = GST_TRACER(self);
+    gst_tracing_register_hook(tracer, "pad-push-pre", G_CALLBACK(do_push_buffer_pre));
+    gst_tracing_register_hook(tracer, "pad-push-list-pre", G_CALLBACK(do_push_buffer_list_pre));
+    gst_tracing_register_hook(tracer, "element-post-message-pre",
+                              G_CALLBACK(do_post_message_pre));
+}
+
+// Data moves through ghost/proxy pads too; only real elements are accounted.
+static GstElement *getParentElement(GstPad *pad)
+{
+    if (pad == nullptr)
+        return nullptr;
+
+    GstObject *parent = GST_OBJECT_PARENT(pad);
+    if (parent == nullptr || !GST_IS_ELEMENT(parent) || GST_IS_BIN(parent))
+        return nullptr;
+
+    return GST_ELEMENT_CAST(parent);
+}
+
+// First field of schedstat is the time spent on the cpu in ns.
+static bool readThreadCpuTime(pid_t tid, uint64_t &cpu_time)
+{
+    std::ifstream schedstat("/proc/self/task/" + std::to_string(tid) + "/schedstat");
+    return static_cast<bool>(schedstat >> cpu_time);
+}
+
+StatsTracer &StatsTracer::getInstance()
+{
+    static StatsTracer instance;
+    return instance;
+}
+
+bool StatsTracer::enable()
+{
+    if (tracer_ != nullptr)
+        return true;
+
+    reset();
+
+    tracer_ = GST_TRACER(g_object_new(grp_stats_tracer_get_type(), nullptr));
+    if (tracer_ == nullptr)
+    {
+        LOGE("Failed to create stats tracer");
+        return false;
+    }
+    gst_object_ref_sink(tracer_);
+
+    LOGI("stats tracer enabled");
+    return true;
+}
+
+void StatsTracer::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    elements_.clear();
+    threads_.clear();
+    start_ = gst_util_get_timestamp();
+}
+
+StatsTracer::element_data_t &StatsTracer::getElementData(GstElement *element)
+{
+    auto it = elements_.find(element);
+    if (it == elements_.end())
+    {
+        it              = elements_.emplace(element, element_data_t()).first;
+        it->second.name = GST_OBJECT_NAME(element) ? GST_OBJECT_NAME(element) : "";
+    }
+    return it->second;
+}
+
+void StatsTracer::onBufferPush(GstClockTime ts, GstPad *pad, GstBuffer *buffer)
+{
+    GstElement *src  = getParentElement(pad);
+    GstElement *dst  = getParentElement(GST_PAD_PEER(pad));
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    pid_t tid        = gettid();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (src != nullptr)
+    {
+        element_data_t &data = getElementData(src);
+        data.buffers_out++;
+
+        // Match the buffer that entered the element with the same pts. Buffers without pts
+        // (muxer output) are matched in arrival order.
+        auto entry = data.pending.begin();
+        if (GST_CLOCK_TIME_IS_VALID(pts))
+        {
+            while (entry != data.pending.end() && entry->first != pts)
+                ++entry;
+        }
+
+        if (entry != data.pending.end())
+        {
+            uint64_t latency = (ts > entry->second) ? ts - entry->second : 0;
+            data.latency_sum += latency;
+            data.latency_count++;
+            if (latency > data.latency_max)
+                data.latency_max = latency;
+
+            size_t bucket = 0;
+            uint64_t us   = latency / 1000;
+            while (bucket < kHistogramSize - 1 && (1ULL << bucket) <= us)
+                bucket++;
+            data.histogram[bucket]++;
+
+            data.pending.erase(data.pending.begin(), entry + 1);
+        }
+
+        // The first element pushing in a thread is the one driving that streaming thread.
+        if (data.last_tid != tid)
+        {
+            data.last_tid = tid;
+            threads_.emplace(tid, thread_data_t{src, 0});
+        }
+    }
+
+    if (dst != nullptr)
+    {
+        element_data_t &data = getElementData(dst);
+        data.buffers_in++;
+        data.pending.emplace_back(pts, ts);
+        if (data.pending.size() > kMaxPending)
+            data.pending.pop_front();
+    }
+}
+
+void StatsTracer::onBufferListPush(GstClockTime ts, GstPad *pad, GstBufferList *list)
+{
+    guint size = gst_buffer_list_length(list);
+    for (guint i = 0; i < size; i++)
+    {
+        onBufferPush(ts, pad, gst_buffer_list_get(list, i));
+    }
+}
+
+void StatsTracer::onMessagePost(GstElement *element, GstMessage *message)
+{
+    if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_QOS || GST_IS_BIN(element))
+        return;
+
+    GstFormat format;
+    guint64 processed = 0;
+    guint64 dropped   = 0;
+    gst_message_parse_qos_stats(message, &format, &processed, &dropped);
+    if (format != GST_FORMAT_BUFFERS && format != GST_FORMAT_DEFAULT)
+        return;
+    if (dropped == static_cast<guint64>(-1))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    getElementData(element).dropped = dropped;
+}
+
+base::pipeline_stats_t StatsTracer::getStatistics()
+{
+    base::pipeline_stats_t stats = {};
+    stats.enabled                = isEnabled();
+    if (!stats.enabled)
+        return stats;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.elapsed = gst_util_get_timestamp() - start_;
+
+    // Threads that have already exited keep their last known cpu time.
+    std::map<GstElement *, uint64_t> cpu_times;
+    for (auto &thread : threads_)
+    {
+        readThreadCpuTime(thread.first, thread.second.cpu_time);
+        cpu_times[thread.second.owner] += thread.second.cpu_time;
+    }
+
+    for (const auto &it : elements_)
+    {
+        const element_data_t &data = it.second;
+
+        base::element_stats_t element = {};
+        element.name                  = data.name;
+        element.buffers_in            = data.buffers_in;
+        element.buffers_out           = data.buffers_out;
+        element.dropped               = data.dropped;
+        element.latency_avg = data.latency_count ? data.latency_sum / data.latency_count : 0;
+        element.latency_max = data.latency_max;
+        element.latency_histogram.assign(data.histogram, data.histogram + kHistogramSize);
+        element.cpu_time = cpu_times[it.first];
+
+        stats.elements.push_back(std::move(element));
+    }
+
+    return stats;
+}
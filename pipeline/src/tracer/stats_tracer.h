@@ -0,0 +1,82 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STATS_TRACER_H_
+#define STATS_TRACER_H_
+
+#include "base.h"
+#include <deque>
+#include <gst/gst.h>
+#include <map>
+#include <mutex>
+#include <sys/types.h>
+
+/**
+ * Per-element buffer statistics collected through GstTracer hooks.
+ * Hooks are process wide, so one instance serves the pipeline of this process.
+ * It is opt-in (see "stats_tracer" in gst_debug.conf) and costs nothing when disabled.
+ */
+class StatsTracer
+{
+    static const size_t kHistogramSize = 16;
+    static const size_t kMaxPending    = 64;
+
+    struct element_data_t
+    {
+        std::string name;
+        uint64_t buffers_in{0};
+        uint64_t buffers_out{0};
+        uint64_t dropped{0};
+        uint64_t latency_sum{0};
+        uint64_t latency_count{0};
+        uint64_t latency_max{0};
+        uint64_t histogram[kHistogramSize]{};
+        std::deque<std::pair<GstClockTime, GstClockTime>> pending; // (pts, entry time)
+        pid_t last_tid{0};
+    };
+
+    struct thread_data_t
+    {
+        GstElement *owner;
+        uint64_t cpu_time;
+    };
+
+    GstTracer *tracer_{nullptr};
+    GstClockTime start_{0};
+    std::mutex mutex_;
+    std::map<GstElement *, element_data_t> elements_;
+    std::map<pid_t, thread_data_t> threads_;
+
+    StatsTracer() = default;
+    element_data_t &getElementData(GstElement *element);
+
+public:
+    static StatsTracer &getInstance();
+
+    StatsTracer(StatsTracer const &)            = delete;
+    StatsTracer &operator=(StatsTracer const &) = delete;
+
+    bool enable();
+    bool isEnabled() const { return tracer_ != nullptr; }
+    void reset();
+    base::pipeline_stats_t getStatistics();
+
+    void onBufferPush(GstClockTime ts, GstPad *pad, GstBuffer *buffer);
+    void onBufferListPush(GstClockTime ts, GstPad *pad, GstBufferList *list);
+    void onMessagePost(GstElement *element, GstMessage *message);
+};
+
+#endif // STATS_TRACER_H_
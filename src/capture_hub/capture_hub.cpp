@@ -0,0 +1,188 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "CaptureHub"
+#include "capture_hub.h"
+#include "control_channel.h"
+#include "generate_unique_id.h"
+#include "json_utils.h"
+#include "log.h"
+#include "process.h"
+#include <algorithm>
+#include <glib.h>
+#include <nlohmann/json.hpp>
+
+using namespace nlohmann;
+
+CaptureHub &CaptureHub::getInstance()
+{
+    static CaptureHub instance;
+    return instance;
+}
+
+std::string CaptureHub::startHub(const std::string &key, const std::string &payload,
+                                 hub_t &hub)
+{
+    // Create hub pipeline, it has nothing to notify. Once stopping, its channel is dropped
+    // from the main loop when the pipeline has gone away.
+    hub.channel = std::make_unique<ControlChannel>(
+        "hub", nullptr,
+        [this]()
+        {
+            g_idle_add(
+                +[](gpointer data) -> gboolean
+                {
+                    static_cast<CaptureHub *>(data)->reapStopped();
+                    return G_SOURCE_REMOVE;
+                },
+                this);
+        });
+    hub.process = hub.channel->spawn();
+
+    // send message for load
+    PLOGI("%s start '%s'", key.c_str(), payload.c_str());
+
+    // A hub that failed to start is still kept, so that release() stops its process.
+    // Recordings then do the work themselves.
+    if (!hub.channel->call(control::CMD_START, payload))
+    {
+        PLOGE("Failed to start hub %s", key.c_str());
+        hub.socketPath.clear();
+    }
+
+    hub.refCount     = 1;
+    std::string path = hub.socketPath;
+    hubs_[key]       = std::move(hub);
+    return path;
+}
+
+std::string CaptureHub::acquire(const std::string &videoSrc, unsigned int width,
+                                unsigned int height)
+{
+    auto it = hubs_.find(videoSrc);
+    if (it != hubs_.end())
+    {
+        it->second.refCount++;
+        PLOGI("%s refCount %d", videoSrc.c_str(), it->second.refCount);
+        return it->second.socketPath;
+    }
+
+    hub_t hub;
+    // unique, a hub of the same camera may still be stopping
+    hub.socketPath = "/tmp/mediarecorder-hub-" + GenerateUniqueID()();
+
+    // Make payload
+    json j;
+    j["hub"]["videoSrc"]   = videoSrc;
+    j["hub"]["socketPath"] = hub.socketPath;
+    j["hub"]["width"]      = width;
+    j["hub"]["height"]     = height;
+    j["statusInterval"]    = 0;
+
+    return startHub(videoSrc, to_string(j), hub);
+}
+
+std::string CaptureHub::acquireEncoder(const std::string &videoSrc, const video_format_t &format,
+                                       std::string &key)
+{
+    key = videoSrc + "/" + format.codec + "/" + std::to_string(format.width) + "x" +
+          std::to_string(format.height) + "@" + std::to_string(format.fps) + "/" +
+          std::to_string(format.bitRate);
+
+    auto it = hubs_.find(key);
+    if (it != hubs_.end())
+    {
+        it->second.refCount++;
+        PLOGI("%s refCount %d", key.c_str(), it->second.refCount);
+        return it->second.socketPath;
+    }
+
+    hub_t hub;
+    hub.socketPath = "/tmp/mediarecorder-enc-" + GenerateUniqueID()();
+
+    // The encoder reads the camera through the capture hub, so that recordings of the
+    // same camera with other settings still share the capture.
+    hub.captureKey            = videoSrc;
+    std::string hubSocketPath = acquire(videoSrc, format.width, format.height);
+
+    // Make payload
+    auto video              = json::object();
+    video["videoSrc"]       = videoSrc;
+    video["width"]          = format.width;
+    video["height"]         = format.height;
+    video["codec"]          = format.codec;
+    video["fps"]            = format.fps;
+    video["bitRate"]        = format.bitRate;
+    video["encoderHubPath"] = hub.socketPath;
+    if (!hubSocketPath.empty())
+        video["hubSocketPath"] = hubSocketPath;
+
+    json j;
+    j["video"]          = std::move(video);
+    j["statusInterval"] = 0;
+
+    return startHub(key, to_string(j), hub);
+}
+
+void CaptureHub::release(const std::string &key)
+{
+    auto it = hubs_.find(key);
+    if (it == hubs_.end())
+        return;
+
+    if (--it->second.refCount > 0)
+    {
+        PLOGI("%s refCount %d", key.c_str(), it->second.refCount);
+        return;
+    }
+
+    // send message, the main loop does not wait for the hub to stop
+    PLOGI("%s stop", key.c_str());
+    if (it->second.channel->post(control::CMD_STOP))
+        stopping_.push_back(std::move(it->second.channel));
+
+    // the process is reaped on the main loop, and killed if it hangs
+    std::string captureKey = it->second.captureKey;
+    hubs_.erase(it);
+
+    if (!captureKey.empty())
+        release(captureKey);
+}
+
+void CaptureHub::reapStopped()
+{
+    stopping_.erase(std::remove_if(stopping_.begin(), stopping_.end(),
+                                   [](const std::unique_ptr<ControlChannel> &channel)
+                                   { return channel->isClosed(); }),
+                    stopping_.end());
+}
+
+bool CaptureHub::requestKeyFrame(const std::string &key)
+{
+    auto it = hubs_.find(key);
+    if (it == hubs_.end() || it->second.socketPath.empty())
+        return false;
+
+    // send message
+    PLOGI("%s requestKeyFrame", key.c_str());
+    return it->second.channel->call(control::CMD_REQUEST_KEY_FRAME);
+}
+
+std::string CaptureHub::getSocketPath(const std::string &key) const
+{
+    auto it = hubs_.find(key);
+    return (it != hubs_.end()) ? it->second.socketPath : "";
+}
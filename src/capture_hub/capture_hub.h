@@ -0,0 +1,76 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include "format_utils.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ControlChannel;
+class Process;
+
+/**
+ * Keeps the hub pipelines shared by recordings while those are running.
+ * A capture hub reads and converts the frames of a camera once and republishes them on a shm
+ * socket that every recording and snapshot of that camera attaches to.
+ * An encoder hub encodes a camera once for all recordings asking for the same video settings
+ * and republishes the encoded stream, each recording then only muxes it.
+ * A released hub is stopped without waiting for it. Its channel is kept until the pipeline
+ * has gone away, its process is killed if it does not exit in time.
+ */
+class CaptureHub
+{
+    struct hub_t
+    {
+        std::unique_ptr<Process> process;
+        std::unique_ptr<ControlChannel> channel;
+        std::string socketPath;
+        std::string captureKey; // capture hub an encoder hub reads from
+        int refCount = 0;
+    };
+
+    std::map<std::string, hub_t> hubs_;
+
+    // channels of the released hubs still stopping
+    std::vector<std::unique_ptr<ControlChannel>> stopping_;
+
+    CaptureHub() = default;
+
+    std::string startHub(const std::string &key, const std::string &payload, hub_t &hub);
+    void reapStopped();
+
+public:
+    static CaptureHub &getInstance();
+
+    CaptureHub(CaptureHub const &)            = delete;
+    CaptureHub &operator=(CaptureHub const &) = delete;
+
+    // Returns the socket the camera is republished on, empty if the hub failed to start.
+    // The camera is the key to release the hub with.
+    std::string acquire(const std::string &videoSrc, unsigned int width, unsigned int height);
+
+    // Returns the socket the encoded stream is published on, empty if the hub failed to start.
+    // key is set to the key to release the hub with.
+    std::string acquireEncoder(const std::string &videoSrc, const video_format_t &format,
+                               std::string &key);
+
+    // Every acquire() has to be paired with a release().
+    void release(const std::string &key);
+    bool requestKeyFrame(const std::string &key);
+    std::string getSocketPath(const std::string &key) const;
+};
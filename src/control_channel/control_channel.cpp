@@ -0,0 +1,193 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "ControlChannel"
+#include "control_channel.h"
+#include "flight_recorder.h"
+#include "log.h"
+#include "process.h"
+#include <chrono>
+#include <unistd.h>
+
+ControlChannel::ControlChannel(const std::string &name, Handler handler, ClosedHandler closed)
+    : name_(name), handler_(std::move(handler)), closedHandler_(std::move(closed))
+{
+    // Both ends are close-on-exec, the pipeline clears it on its own end only. Pipelines
+    // spawned meanwhile for other recordings would otherwise keep this channel open.
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+    {
+        PLOGE("%s socketpair error : %d", name_.c_str(), errno);
+        closed_ = true;
+        return;
+    }
+    fd_     = fds[0];
+    peerFd_ = fds[1];
+
+    readThread_ = std::make_unique<std::thread>(&ControlChannel::readLoop, this);
+    pthread_setname_np(readThread_->native_handle(), name_.c_str());
+}
+
+ControlChannel::~ControlChannel()
+{
+    PLOGI("%s", name_.c_str());
+
+    // closed by this end, the closed handler is not called
+    destroying_ = true;
+    if (fd_ >= 0)
+        shutdown(fd_, SHUT_RDWR);
+
+    // never from the handler, see the header
+    if (readThread_ && readThread_->joinable())
+        readThread_->join();
+
+    if (peerFd_ >= 0)
+        close(peerFd_);
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+std::unique_ptr<Process> ControlChannel::spawn()
+{
+    // the pipeline finds its end at Process::kControlFd
+    auto process = std::make_unique<Process>(
+        std::vector<std::string>{"/usr/sbin/g-record-pipeline",
+                                 "-c" + std::to_string(Process::kControlFd)},
+        peerFd_);
+
+    // Only the pipeline holds the other end now, its exit ends the channel.
+    if (peerFd_ >= 0)
+    {
+        close(peerFd_);
+        peerFd_ = -1;
+    }
+    return process;
+}
+
+void ControlChannel::readLoop()
+{
+    control::header_t header;
+    std::string payload;
+    while (control::receive(fd_, header, payload))
+    {
+        if (header.type == control::REPLY)
+        {
+            std::lock_guard<std::mutex> lock(replyMutex_);
+            if (header.seq != seq_)
+            {
+                PLOGW("%s late reply %u to %u", name_.c_str(), header.seq, header.code);
+                continue;
+            }
+            reply_        = header;
+            replyPayload_ = std::move(payload);
+            replied_      = true;
+            replyCond_.notify_all();
+        }
+        else if (header.type == control::NOTIFY && handler_)
+        {
+            flight::record(flight::EV_NOTIFY, header.code, header.result, name_.c_str());
+            handler_(header.code, header.result, payload);
+        }
+    }
+
+    PLOGI("%s closed", name_.c_str());
+    {
+        std::lock_guard<std::mutex> lock(replyMutex_);
+        closed_ = true;
+        replyCond_.notify_all();
+    }
+
+    if (closedHandler_ && !destroying_)
+        closedHandler_();
+}
+
+bool ControlChannel::call(control::command_t command, const std::string &payload,
+                          std::string *reply, int timeout)
+{
+    std::lock_guard<std::mutex> callLock(callMutex_);
+
+    control::header_t header{};
+    {
+        std::lock_guard<std::mutex> lock(replyMutex_);
+        if (closed_)
+        {
+            PLOGE("%s is closed", name_.c_str());
+            return false;
+        }
+        header.seq = ++seq_;
+        replied_   = false;
+    }
+    header.type   = control::REQUEST;
+    header.code   = command;
+    header.length = payload.size();
+
+    if (!control::send(fd_, header, payload.data()))
+    {
+        PLOGE("%s fails to send %u : %d", name_.c_str(), command, errno);
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(replyMutex_);
+    if (!replyCond_.wait_for(lock, std::chrono::milliseconds(timeout),
+                             [this]() { return replied_ || closed_; }) ||
+        !replied_)
+    {
+        PLOGE("%s no reply to %u", name_.c_str(), command);
+        flight::record(flight::EV_TIMEOUT, command, 0, name_.c_str());
+        if (!closed_)
+            flight::dump("timeout");
+        return false;
+    }
+
+    flight::record(flight::EV_COMMAND, command, reply_.result, name_.c_str());
+    if (reply)
+        *reply = std::move(replyPayload_);
+    return reply_.result == 0;
+}
+
+bool ControlChannel::post(control::command_t command, const std::string &payload)
+{
+    std::lock_guard<std::mutex> callLock(callMutex_);
+
+    control::header_t header{};
+    {
+        std::lock_guard<std::mutex> lock(replyMutex_);
+        if (closed_)
+        {
+            PLOGE("%s is closed", name_.c_str());
+            return false;
+        }
+        header.seq = ++seq_;
+    }
+    header.type   = control::REQUEST;
+    header.code   = command;
+    header.length = payload.size();
+
+    if (!control::send(fd_, header, payload.data()))
+    {
+        PLOGE("%s fails to send %u : %d", name_.c_str(), command, errno);
+        return false;
+    }
+
+    flight::record(flight::EV_COMMAND, command, 0, name_.c_str());
+    return true;
+}
+
+bool ControlChannel::isClosed()
+{
+    std::lock_guard<std::mutex> lock(replyMutex_);
+    return closed_;
+}
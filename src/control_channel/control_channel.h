@@ -0,0 +1,85 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef CONTROL_CHANNEL_
+#define CONTROL_CHANNEL_
+
+#include "control_protocol.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Process;
+
+/**
+ * Service end of the control channel of a g-record-pipeline process.
+ * Requests are sent one at a time and wait for their reply. Notifications are handed to
+ * the handler on the thread reading the channel, the way LSConnector calls a subscription.
+ * The destructor joins that thread, so a channel must not be destroyed from its handler;
+ * defer it to the main loop instead, as releaseFinalized does. The same holds for the closed
+ * handler, called on that thread once the pipeline has gone away.
+ */
+class ControlChannel
+{
+public:
+    using Handler = std::function<void(uint16_t event, int32_t result, const std::string &)>;
+    using ClosedHandler = std::function<void()>;
+
+private:
+    int fd_     = -1;
+    int peerFd_ = -1;
+    std::string name_;
+    Handler handler_;
+    ClosedHandler closedHandler_;
+    std::unique_ptr<std::thread> readThread_;
+    std::atomic<bool> destroying_{false};
+
+    std::mutex callMutex_; // one request in flight
+    std::mutex replyMutex_;
+    std::condition_variable replyCond_;
+    uint32_t seq_ = 0;
+    bool replied_ = false;
+    bool closed_  = false;
+    control::header_t reply_{};
+    std::string replyPayload_;
+
+    void readLoop();
+
+public:
+    ControlChannel(const std::string &name, Handler handler, ClosedHandler closed = nullptr);
+    ~ControlChannel();
+
+    ControlChannel(ControlChannel const &)            = delete;
+    ControlChannel &operator=(ControlChannel const &) = delete;
+
+    // Starts g-record-pipeline with the other end of the channel.
+    std::unique_ptr<Process> spawn();
+
+    // True if the pipeline replied with success, the reply payload goes to reply if given.
+    bool call(control::command_t command, const std::string &payload = "",
+              std::string *reply = nullptr, int timeout = 2000);
+
+    // Sends a request without waiting for its reply, which is dropped.
+    bool post(control::command_t command, const std::string &payload = "");
+
+    bool isClosed();
+};
+
+#endif // CONTROL_CHANNEL_
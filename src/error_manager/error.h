@@ -30,11 +30,16 @@ enum ErrorCode
     ERR_VIDEO_BITRATE_OUT_OF_RANGE = 530,
     ERR_UNSUPPORTED_AUDIO_FORMAT   = 540,
     ERR_UNSUPPORTED_VIDEO_FORMAT   = 550,
+    ERR_UNSUPPORTED_LIVE_OUTPUT    = 560,
+    ERR_UNSUPPORTED_LAYOUT         = 570,
+    ERR_PROFILE_NOT_SPECIFIED      = 580,
+    ERR_PROFILE_NOT_FOUND          = 590,
     ERR_FAILED_TO_START_RECORDING  = 600,
     ERR_FAILED_TO_STOP_RECORDING   = 610,
     ERR_SNAPSHOT_CAPTURE_FAILED    = 620,
     ERR_FAILED_TO_PAUSE            = 630,
     ERR_FAILED_TO_RESUME           = 640,
+    ERR_FAILED_TO_GET_STATISTICS   = 650,
     ERR_OPEN_FAIL                  = 700,
     ERR_CLOSE_FAIL                 = 710,
     ERR_VIDEO_NOT_OPENED           = 720,
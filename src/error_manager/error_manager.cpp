@@ -52,6 +52,10 @@ void ErrorManager::registerErrors()
     addError(ERR_VIDEO_BITRATE_OUT_OF_RANGE, "Video bitrate is out of range");
     addError(ERR_UNSUPPORTED_AUDIO_FORMAT, "Unsupported audio format");
     addError(ERR_UNSUPPORTED_VIDEO_FORMAT, "Unsupported video format");
+    addError(ERR_UNSUPPORTED_LIVE_OUTPUT, "Unsupported live output");
+    addError(ERR_UNSUPPORTED_LAYOUT, "Unsupported composite layout");
+    addError(ERR_PROFILE_NOT_SPECIFIED, "Profile name must be specified");
+    addError(ERR_PROFILE_NOT_FOUND, "Profile not found");
 
     // 600
     addError(ERR_FAILED_TO_START_RECORDING, "Failed to start recording");
@@ -59,6 +63,7 @@ void ErrorManager::registerErrors()
     addError(ERR_SNAPSHOT_CAPTURE_FAILED, "Snapshot capture failed");
     addError(ERR_FAILED_TO_PAUSE, "Failed to pause");
     addError(ERR_FAILED_TO_RESUME, "Failed to resume");
+    addError(ERR_FAILED_TO_GET_STATISTICS, "Failed to get statistics");
 
     // 700
     addError(ERR_OPEN_FAIL, "Failed to open recorder");
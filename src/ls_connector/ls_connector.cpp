@@ -3,7 +3,16 @@
 #include "log.h"
 #include <system_error>
 
-LSConnector::LSConnector(const std::string &service_name, const std::string &thread_name)
+// one registration for the calls of every recorder
+static const char *const kServiceName = "com.webos.service.mediarecorder-client";
+
+LSConnector &LSConnector::getInstance()
+{
+    static LSConnector instance;
+    return instance;
+}
+
+LSConnector::LSConnector()
 {
     PLOGI("start");
 
@@ -23,9 +32,9 @@ LSConnector::LSConnector(const std::string &service_name, const std::string &thr
     {
     }
 
-    pthread_setname_np(loopThread_->native_handle(), thread_name.c_str());
+    pthread_setname_np(loopThread_->native_handle(), "luna");
 
-    luna_client = std::make_unique<LunaClient>(service_name.c_str(), c);
+    luna_client = std::make_unique<LunaClient>(kServiceName, c);
     g_main_context_unref(c);
 }
 
@@ -52,20 +61,3 @@ bool LSConnector::callSync(const char *uri, const char *param, std::string *resu
 {
     return luna_client->callSync(uri, param, result, timeout);
 }
-
-bool LSConnector::subscribe(const char *uri, const char *param, Handler handler, void *data)
-{
-    bool ret = luna_client->subscribe(uri, param, &subscribeKey_, handler, data);
-    PLOGI("subscribeKey %ld", subscribeKey_);
-    return ret;
-}
-bool LSConnector::unsubscribe()
-{
-    if (subscribeKey_)
-    {
-        PLOGI("subscribeKey %ld", subscribeKey_);
-        return luna_client->unsubscribe(subscribeKey_);
-    }
-
-    return true;
-}
@@ -6,20 +6,25 @@
 #include <string>
 #include <thread>
 
+/**
+ * Luna client shared by all recorders, registered once and served by one loop thread.
+ */
 class LSConnector
 {
     std::unique_ptr<LunaClient> luna_client{nullptr};
     GMainLoop *loop_{nullptr};
     std::unique_ptr<std::thread> loopThread_;
-    unsigned long subscribeKey_{0};
+
+    LSConnector();
 
 public:
-    LSConnector(const std::string &service_name, const std::string &thread_name);
+    static LSConnector &getInstance();
     ~LSConnector();
 
+    LSConnector(LSConnector const &)            = delete;
+    LSConnector &operator=(LSConnector const &) = delete;
+
     bool callSync(const char *uri, const char *param, std::string *result, int timeout = 2000);
-    bool subscribe(const char *uri, const char *param, Handler handler, void *data);
-    bool unsubscribe();
 };
 
 #endif // LS_CONNECTOR_
@@ -16,11 +16,13 @@
 
 #define LOG_TAG "MediaRecorder"
 #include "media_recorder.h"
-#include "generate_unique_id.h"
+#include "capture_hub.h"
+#include "control_channel.h"
 #include "json_utils.h"
 #include "log.h"
 #include "ls_connector.h"
 #include "process.h"
+#include <cstring>
 #include <nlohmann/json.hpp>
 #include <random>
 #include <sys/time.h>
@@ -29,13 +31,18 @@ using namespace nlohmann;
 
 const char *const mediaIdStr     = "mediaId";
 const char *const returnValueStr = "returnValue";
-const char *const emptyJson      = "{}";
 
-const std::string mp4Format = "MP4";
-const std::string m4aFormat = "M4A";
+const std::string mp4Format  = "MP4";
+const std::string m4aFormat  = "M4A";
+const std::string oggFormat  = "OGG";
+const std::string flacFormat = "FLAC";
+const std::string wavFormat  = "WAV";
 
-#define LUNA_CALLBACK(NAME)                                                                        \
-    +[](const char *m, void *c) -> bool { return ((MediaRecorder *)c)->NAME(m); }
+const audio_format_t MediaRecorder::mAudioFormatDefault = {"AAC", 44100, 2, 0};
+
+// cameras a recording can composite or record as tracks, and the gap of pip insets
+const size_t kMaxCompositeSrcs      = 4;
+const unsigned int kCompositeMargin = 16;
 
 // Get random number between 1000 and 9999
 static int getRandomNumber()
@@ -68,7 +75,7 @@ static bool isSupportedVideoFileFormat(const std::string &input)
 static bool isSupportedAudioFileFormat(const std::string &input)
 {
     std::vector<std::string> audioFileTypes = {
-        m4aFormat
+        m4aFormat, oggFormat, flacFormat, wavFormat
         // You can add additional file formats here.
     };
 
@@ -119,24 +126,41 @@ static bool isSupportedVideoCodec(const std::string &input)
     return false;
 }
 
+static bool isSupportedVideoBitRate(unsigned int bitRate)
+{
+    return bitRate >= 25000 && bitRate <= 25000000;
+}
+
 static ErrorCode isSupportedAudioFormat(const std::string &codec, const unsigned int sampleRate,
                                         const unsigned int channels, const unsigned int bitRate)
 {
     std::vector<audio_support_list_t> audioSupportTypes = {
         // Additional audio format types can be added here.
-        // example
-        //{"AAC_check_bitrate", {32000, 44100, 48000}, {1, 2, 3, 4, 5}, {0,
+        // example, a list of bitrates restricts the bitrate as well
+        //{"AAC", {32000, 44100, 48000}, {1, 2, 3, 4, 5}, {0,
         // 64000,128000,192000,256000}},
         {"AAC",
          {7350, 8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000, 64000, 88200, 96000},
          {1, 2, 3, 4, 5},
+         {}},
+        // voice at a fraction of the cpu and bitrate of AAC
+        {"OPUS", {8000, 12000, 16000, 24000, 48000}, {1, 2}, {}},
+        // lossless
+        {"FLAC",
+         {8000, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000},
+         {1, 2, 4, 6, 8},
+         {}},
+        // not encoded at all
+        {"PCM",
+         {8000, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000},
+         {1, 2, 4, 6, 8},
          {}}};
 
     auto pos = std::find_if(
         audioSupportTypes.begin(), audioSupportTypes.end(),
         [&](audio_support_list_t &i)
         {
-            if (i.codec == "AAC")
+            if (i.bitRate.empty())
             {
                 auto samplePos =
                     std::find_if(i.sampleRate.begin(), i.sampleRate.end(),
@@ -156,7 +180,7 @@ static ErrorCode isSupportedAudioFormat(const std::string &codec, const unsigned
                     return false;
                 }
             }
-            else if (i.codec == "AAC_check_bitrate")
+            else
             {
                 auto samplePos =
                     std::find_if(i.sampleRate.begin(), i.sampleRate.end(),
@@ -179,10 +203,6 @@ static ErrorCode isSupportedAudioFormat(const std::string &codec, const unsigned
                     return false;
                 }
             }
-            else
-            {
-                return false;
-            }
         });
 
     if (pos != audioSupportTypes.end())
@@ -195,6 +215,24 @@ static ErrorCode isSupportedAudioFormat(const std::string &codec, const unsigned
     }
 }
 
+// Codecs each file format can carry
+static bool isSupportedAudioCodecInFormat(const std::string &format, const std::string &codec)
+{
+    std::vector<std::pair<std::string, std::string>> audioCodecFormats = {
+        {mp4Format, "AAC"},  {m4aFormat, "AAC"},   {oggFormat, "OPUS"},
+        {oggFormat, "FLAC"}, {flacFormat, "FLAC"}, {wavFormat, "PCM"}};
+
+    for (const auto &codecFormat : audioCodecFormats)
+    {
+        if (codecFormat.first == format && codecFormat.second == codec)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static bool isInTargetFolders(const std::string &path)
 {
     std::vector<std::string> targetFolders = {
@@ -212,6 +250,13 @@ static bool isInTargetFolders(const std::string &path)
     return false;
 }
 
+static json toJson(const control::recording_status_t &status)
+{
+    return {{"duration", status.duration}, {"bytes", status.bytes},
+            {"bitrate", status.bitrate},   {"fps", status.fps},
+            {"frames", status.frames},     {"dropped", status.dropped}};
+}
+
 MediaRecorder::MediaRecorder() { PLOGI(""); }
 
 MediaRecorder::~MediaRecorder()
@@ -221,9 +266,12 @@ MediaRecorder::~MediaRecorder()
     {
         close();
     }
+    mFinalizing.clear();
 }
 
-ErrorCode MediaRecorder::open(std::string &video_src, bool audio_src)
+ErrorCode MediaRecorder::open(std::string &video_src, bool audio_src,
+                              const std::vector<std::string> &composite_srcs,
+                              const std::string &layout)
 {
     PLOGI("");
 
@@ -233,9 +281,22 @@ ErrorCode MediaRecorder::open(std::string &video_src, bool audio_src)
         return ERR_SOURCE_NOT_SPECIFIED;
     }
 
-    videoSrc   = video_src;
-    audioSrc   = audio_src;
-    recorderId = getRandomNumber();
+    if (!composite_srcs.empty())
+    {
+        if (composite_srcs.size() >= kMaxCompositeSrcs ||
+            (layout != "pip" && layout != "grid" && layout != "tracks"))
+        {
+            PLOGE("Unsupported layout %s for %zu cameras", layout.c_str(),
+                  composite_srcs.size() + 1);
+            return ERR_UNSUPPORTED_LAYOUT;
+        }
+    }
+
+    videoSrc       = video_src;
+    audioSrc       = audio_src;
+    mCompositeSrcs = composite_srcs;
+    mLayout        = layout;
+    recorderId     = getRandomNumber();
 
     // set default audio format
     if (audioSrc)
@@ -259,6 +320,7 @@ ErrorCode MediaRecorder::close()
         return ERR_INVALID_STATE;
     }
 
+    // Recordings still finalizing are kept, their finalized notification is still sent.
     state = CLOSE;
     return ERR_NONE;
 }
@@ -272,15 +334,21 @@ ErrorCode MediaRecorder::setOutputFile(std::string &path)
         return ERR_INVALID_STATE;
     }
 
-    if (!isInTargetFolders(path))
+    ErrorCode err = checkOutputFile(path);
+    if (err != ERR_NONE)
     {
-        return ERR_CANNOT_WRITE;
+        return err;
     }
 
     mRecordBasePath = path;
     return ERR_NONE;
 }
 
+ErrorCode MediaRecorder::checkOutputFile(const std::string &path)
+{
+    return isInTargetFolders(path) ? ERR_NONE : ERR_CANNOT_WRITE;
+}
+
 ErrorCode MediaRecorder::setOutputFormat(std::string &format)
 {
     PLOGI("");
@@ -291,18 +359,26 @@ ErrorCode MediaRecorder::setOutputFormat(std::string &format)
     }
 
     mFormat = format;
+    return checkOutputFormat(format, !videoSrc.empty());
+}
 
-    if (!videoSrc.empty())
+ErrorCode MediaRecorder::checkOutputFormat(const std::string &format, bool video,
+                                           const std::string &audioCodec)
+{
+    if (video ? !isSupportedVideoFileFormat(format) : !isSupportedAudioFileFormat(format))
     {
-        return isSupportedVideoFileFormat(format) ? ERR_NONE : ERR_UNSUPPORTED_FORMAT;
+        return ERR_UNSUPPORTED_FORMAT;
     }
-    else
+
+    if (!audioCodec.empty() && !isSupportedAudioCodecInFormat(format, audioCodec))
     {
-        return isSupportedAudioFileFormat(format) ? ERR_NONE : ERR_UNSUPPORTED_FORMAT;
+        PLOGE("%s can not be recorded to %s", audioCodec.c_str(), format.c_str());
+        return ERR_UNSUPPORTED_AUDIO_FORMAT;
     }
+    return ERR_NONE;
 }
 
-ErrorCode MediaRecorder::start()
+ErrorCode MediaRecorder::setLiveOutput(std::string &type, unsigned int port, std::string &path)
 {
     PLOGI("");
     if (state != OPEN)
@@ -311,15 +387,79 @@ ErrorCode MediaRecorder::start()
         return ERR_INVALID_STATE;
     }
 
-    // Create record pipeline
-    std::string guid = GenerateUniqueID()();
-    std::string uid  = "com.webos.pipeline.record." + guid;
-    std::string cmd  = "/usr/sbin/g-record-pipeline -s" + uid;
-    record_process   = std::make_unique<Process>(cmd);
+    if (videoSrc.empty())
+    {
+        PLOGE("video is not opened");
+        return ERR_VIDEO_NOT_OPENED;
+    }
+
+    if (type == "hls" && path.empty())
+    {
+        path = "/tmp/mediarecorder-" + std::to_string(recorderId) + "/";
+    }
+
+    ErrorCode err = checkLiveOutput(type, port, path);
+    if (err != ERR_NONE)
+    {
+        return err;
+    }
+
+    mLiveType = (type == "none") ? "" : type;
+    mLivePort = port;
+    mLivePath = path;
 
-    // Create record client
-    std::string service_name = "com.webos.service.mediarecorder-" + std::to_string(recorderId);
-    record_client            = std::make_unique<LSConnector>(service_name, "record");
+    PLOGI("live output: %s, port %u, path %s", type.c_str(), port, path.c_str());
+    return ERR_NONE;
+}
+
+ErrorCode MediaRecorder::checkLiveOutput(const std::string &type, unsigned int port,
+                                         const std::string &path)
+{
+    if (type == "rtp")
+    {
+        // RTP is only sent to loopback, unprivileged ports
+        if (port < 1024 || port > 65535)
+        {
+            return ERR_UNSUPPORTED_LIVE_OUTPUT;
+        }
+    }
+    else if (type == "hls")
+    {
+        // HLS segments are rewritten continuously, keep them on tmpfs. Empty picks a
+        // directory of the recorder.
+        if (!path.empty() &&
+            (path.compare(0, 5, "/tmp/") != 0 || path.find("..") != std::string::npos))
+        {
+            return ERR_CANNOT_WRITE;
+        }
+    }
+    else if (type != "none")
+    {
+        return ERR_UNSUPPORTED_LIVE_OUTPUT;
+    }
+    return ERR_NONE;
+}
+
+ErrorCode MediaRecorder::start(unsigned int statusInterval, bool encodedTap, bool sharedCapture)
+{
+    PLOGI("");
+    if (state != OPEN)
+    {
+        PLOGE("Invalid state %d", state);
+        return ERR_INVALID_STATE;
+    }
+
+    // Create record pipeline, it is controlled through the channel it inherits
+    record_channel = std::make_unique<ControlChannel>(
+        "record",
+        [this](uint16_t event, int32_t result, const std::string &payload)
+        { recordCb(event, result, payload); },
+        [this]()
+        {
+            if (exitNotifier_)
+                exitNotifier_(recorderId);
+        });
+    record_process = record_channel->spawn();
 
     // Make payload
     auto j = json::object();
@@ -338,7 +478,19 @@ ErrorCode MediaRecorder::start()
         video["codec"]    = mVideoFormat.codec;
         video["fps"]      = mVideoFormat.fps;
         video["bitRate"]  = mVideoFormat.bitRate;
-        j["video"]        = std::move(video);
+        if (mVideoFormat.minBitRate > 0)
+            video["minBitRate"] = mVideoFormat.minBitRate;
+        if (mVideoFormat.minFps > 0)
+            video["minFps"] = mVideoFormat.minFps;
+
+        if (!mCompositeSrcs.empty())
+        {
+            auto composite = json::array();
+            if (!getCompositeLayout(composite))
+                return ERR_CAMERA_OPEN_FAIL;
+            video[(mLayout == "tracks") ? "tracks" : "composite"] = std::move(composite);
+        }
+        j["video"] = std::move(video);
 
         PLOGI("Video Format: codec=%s, width=%d, height=%d, fps=%d, bitRate=%d",
               mVideoFormat.codec.c_str(), mVideoFormat.width, mVideoFormat.height, mVideoFormat.fps,
@@ -375,6 +527,12 @@ ErrorCode MediaRecorder::start()
             return ERR_UNSUPPORTED_AUDIO_FORMAT;
     }
 
+    if (audioSrc && !isSupportedAudioCodecInFormat(mFormat, mAudioFormat.codec))
+    {
+        PLOGE("%s can not be recorded to %s", mAudioFormat.codec.c_str(), mFormat.c_str());
+        return ERR_UNSUPPORTED_AUDIO_FORMAT;
+    }
+
     // If setOutputFile method is not invoked
     if (mRecordBasePath.empty())
     {
@@ -390,25 +548,85 @@ ErrorCode MediaRecorder::start()
         mRecordPath = createRecordFileName(mRecordBasePath, "Audio");
     }
 
-    j["format"] = mFormat;
-    j["path"]   = mRecordPath;
+    j["format"]         = mFormat;
+    j["path"]           = mRecordPath;
+    j["statusInterval"] = statusInterval;
 
-    // send message for load
-    record_uri      = "luna://" + uid + "/";
-    std::string uri = record_uri + __func__;
-    PLOGI("%s '%s'", uri.c_str(), to_string(j).c_str());
+    if (!videoSrc.empty() && !mLiveType.empty())
+    {
+        auto live    = json::object();
+        live["type"] = mLiveType;
+        if (mLiveType == "rtp")
+            live["port"] = mLivePort;
+        else
+            live["path"] = mLivePath;
+        j["liveOutput"] = std::move(live);
+    }
 
-    std::string resp;
-    record_client->callSync(uri.c_str(), to_string(j).c_str(), &resp);
-    PLOGI("resp %s", resp.c_str());
+    mTapSocketPath.clear();
+    if (!videoSrc.empty() && encodedTap)
+    {
+        auto tap          = json::object();
+        tap["socketPath"] = "/tmp/mediarecorder-" + std::to_string(recorderId) + "-tap";
+        j["encodedTap"]   = std::move(tap);
+    }
 
-    json jOut = json::parse(resp);
-    if (get_optional<bool>(jOut, returnValueStr).value_or(false))
+    // Attach to the hub of the camera, it is started by the first recorder.
+    // Recorders with the same fixed video settings share the encode as well,
+    // the ones adapting their rate need an encoder of their own.
+    mSharedHubKey.clear();
+    bool sharedEncoder = false;
+    if (!videoSrc.empty() && mCompositeSrcs.empty() && sharedCapture)
+    {
+        std::string hubSocketPath;
+        if (mVideoFormat.minBitRate == 0 && mVideoFormat.minFps == 0)
+        {
+            hubSocketPath =
+                CaptureHub::getInstance().acquireEncoder(videoSrc, mVideoFormat, mSharedHubKey);
+            sharedEncoder = !hubSocketPath.empty();
+            if (sharedEncoder)
+                j["video"]["sharedEncoderPath"] = hubSocketPath;
+        }
+        else
+        {
+            mSharedHubKey = videoSrc;
+            hubSocketPath =
+                CaptureHub::getInstance().acquire(videoSrc, mVideoFormat.width, mVideoFormat.height);
+            if (!hubSocketPath.empty())
+                j["video"]["hubSocketPath"] = hubSocketPath;
+        }
+    }
+
+    // the status of a previous recording is not reported for this one
+    {
+        std::lock_guard<std::mutex> lock(mStatusMutex);
+        mHasStatus     = false;
+        mStatusPending = false;
+    }
+
+    // send message for load
+    std::string payload = to_string(j);
+    PLOGI("start '%s'", payload.c_str());
+
+    if (record_channel->call(control::CMD_START, payload))
     {
+        if (j.contains("encodedTap"))
+            mTapSocketPath = j["encodedTap"]["socketPath"];
+
+        // The recording starts at the next keyframe of the shared encoder, ask for one now.
+        if (sharedEncoder)
+            CaptureHub::getInstance().requestKeyFrame(mSharedHubKey);
+
         state = RECORDING;
         return ERR_NONE;
     }
 
+    if (!mSharedHubKey.empty())
+    {
+        CaptureHub::getInstance().release(mSharedHubKey);
+        mSharedHubKey.clear();
+    }
+
     return ERR_FAILED_TO_START_RECORDING;
 }
 
@@ -421,31 +639,26 @@ ErrorCode MediaRecorder::stop()
         return ERR_INVALID_STATE;
     }
 
-    // send message
-    std::string uri = record_uri + __func__;
-    PLOGI("%s '%s'", uri.c_str(), emptyJson);
-
-    std::string resp;
-    record_client->callSync(uri.c_str(), emptyJson, &resp, 16000);
-    PLOGI("resp %s", resp.c_str());
-
-    try
+    // send message, the pipeline replies once capture has stopped
+    PLOGI("stop");
+    if (!record_channel->call(control::CMD_STOP, "", nullptr, 16000))
+        return ERR_FAILED_TO_STOP_RECORDING;
+
+    // The channel stays for the finalized notification, a new recording can start
+    // meanwhile with a channel and a pipeline of its own.
+    state               = OPEN;
+    auto finalizing     = std::make_unique<finalizing_t>();
+    finalizing->path    = mRecordPath;
+    finalizing->process = std::move(record_process);
+    finalizing->channel = std::move(record_channel);
+    mFinalizing.push_back(std::move(finalizing));
+
+    if (!mSharedHubKey.empty())
     {
-        json jOut = json::parse(resp);
-        if (get_optional<bool>(jOut, returnValueStr).value_or(false))
-        {
-            state = OPEN;
-            record_process.reset();
-            record_client.reset();
-            return ERR_NONE;
-        }
-    }
-    catch (const json::exception &e)
-    {
-        PLOGE("Error occurred: %s", e.what());
+        CaptureHub::getInstance().release(mSharedHubKey);
+        mSharedHubKey.clear();
     }
-
-    return ERR_FAILED_TO_STOP_RECORDING;
+    return ERR_NONE;
 }
 
 ErrorCode MediaRecorder::takeSnapshot(std::string &path, std::string &format)
@@ -468,31 +681,13 @@ ErrorCode MediaRecorder::takeSnapshot(std::string &path, std::string &format)
         return ERR_UNSUPPORTED_FORMAT;
     }
 
-    // Create snapshot pipeline
-    std::string guid = GenerateUniqueID()();
-    std::string uid  = "com.webos.pipeline.record." + guid;
-    std::string cmd  = "/usr/sbin/g-record-pipeline -s" + uid;
-    Process snapshot_process(cmd);
-
-    // Prepare snapshot client
-    if (snapshot_client == nullptr)
-    {
-        std::string service_name =
-            "com.webos.service.mediarecorder-" + std::to_string(recorderId) + "-snapshot";
-        snapshot_client = std::make_unique<LSConnector>(service_name, "snapshot");
-    }
-
-    // send message for subscribe
-    std::string snapshot_uri = "luna://" + uid + "/";
-    std::string uri          = snapshot_uri + "subscribe";
-    PLOGI("%s '%s'", uri.c_str(), emptyJson);
-    bool retVal =
-        snapshot_client->subscribe(uri.c_str(), emptyJson, LUNA_CALLBACK(snapshotCb), this);
-    if (!retVal)
-    {
-        PLOGE("%s fail to subscribe", __func__);
-        return ERR_SNAPSHOT_CAPTURE_FAILED;
-    }
+    // Create snapshot pipeline, it exits once the channel is closed
+    std::unique_ptr<Process> snapshot_process;
+    ControlChannel snapshot_channel("snapshot",
+                                    [this](uint16_t event, int32_t, const std::string &)
+                                    { snapshotCb(event); });
+    mEos             = false;
+    snapshot_process = snapshot_channel.spawn();
 
     // Make payload
     json j;
@@ -505,21 +700,26 @@ ErrorCode MediaRecorder::takeSnapshot(std::string &path, std::string &format)
         image["height"]   = mVideoFormat.height;
         image["codec"]    = format;
         image["quality"]  = 90;
-        j["image"]        = std::move(image);
+
+        std::string hubSocketPath = CaptureHub::getInstance().getSocketPath(videoSrc);
+        if (!hubSocketPath.empty())
+            image["hubSocketPath"] = hubSocketPath;
+
+        j["image"] = std::move(image);
     }
 
     mCapturePath = createRecordFileName(path, "Capture");
     j["path"]    = mCapturePath;
 
     // send message for load
-    uri = snapshot_uri + "start";
-    PLOGI("%s '%s'", uri.c_str(), to_string(j).c_str());
-
-    std::string resp;
-    snapshot_client->callSync(uri.c_str(), to_string(j).c_str(), &resp);
-    PLOGI("resp %s", resp.c_str());
+    std::string payload = to_string(j);
+    PLOGI("start '%s'", payload.c_str());
+    if (!snapshot_channel.call(control::CMD_START, payload))
+    {
+        PLOGE("%s fail to start", __func__);
+        return ERR_SNAPSHOT_CAPTURE_FAILED;
+    }
 
-    mEos    = false;
     int cnt = 0;
     while (!mEos && cnt < 10000) // 10s
     {
@@ -535,12 +735,8 @@ ErrorCode MediaRecorder::takeSnapshot(std::string &path, std::string &format)
     else
     {
         // send message
-        std::string uri = snapshot_uri + "stop";
-        PLOGI("%s '%s'", uri.c_str(), emptyJson);
-
-        std::string resp;
-        snapshot_client->callSync(uri.c_str(), emptyJson, &resp);
-        PLOGI("resp %s", resp.c_str());
+        PLOGI("stop");
+        snapshot_channel.call(control::CMD_STOP);
 
         // [ToDo] WRR-12818 Time out, it should return capture fail.
         // return  ERR_SNAPSHOT_CAPTURE_FAILED;
@@ -548,30 +744,118 @@ ErrorCode MediaRecorder::takeSnapshot(std::string &path, std::string &format)
     }
 }
 
-bool MediaRecorder::snapshotCb(const char *message)
+void MediaRecorder::snapshotCb(uint16_t event)
 {
-    PLOGI("payload : %s", message);
-
-    json j = json::parse(message, nullptr, false);
-    if (j.is_discarded())
+    if (event == control::EVT_END_OF_STREAM)
     {
-        PLOGE("payload parsing fail!");
-        return false;
+        PLOGI("Got EOS");
+        mEos = true;
     }
+}
 
-    if (j.contains("endOfStream"))
+void MediaRecorder::recordCb(uint16_t event, int32_t result, const std::string &payload)
+{
+    switch (event)
     {
-        PLOGI("Got EOS");
-        mEos = true;
+    case control::EVT_RECORDING_STATUS:
+    {
+        control::recording_status_t status;
+        if (payload.size() != sizeof(status))
+            break;
+        memcpy(&status, payload.data(), sizeof(status));
+
+        // Keep only the latest status. The manager is notified once per batch, so a slow
+        // main loop or slow subscribers see fewer updates instead of a growing backlog.
+        bool notify = false;
+        {
+            std::lock_guard<std::mutex> lock(mStatusMutex);
+            mRecordingStatus = status;
+            mHasStatus       = true;
+            notify           = !mStatusPending;
+            mStatusPending   = true;
+        }
 
-        // send message for unsubscribe
-        bool retVal = snapshot_client->unsubscribe();
-        if (!retVal)
+        if (notify && statusNotifier_)
         {
-            PLOGE("%s fail to unsubscribe", __func__);
+            statusNotifier_(recorderId);
         }
+        break;
+    }
+    case control::EVT_FINALIZED:
+    {
+        control::finalized_t finalized;
+        if (payload.size() < sizeof(finalized))
+            break;
+        memcpy(&finalized, payload.data(), sizeof(finalized));
+
+        json j = {{"path", payload.substr(sizeof(finalized))},
+                  {"duration", finalized.duration},
+                  {"size", finalized.size}};
+        PLOGI("finalized : %s", to_string(j).c_str());
+        if (finalizedNotifier_)
+            finalizedNotifier_(recorderId, j);
+        break;
+    }
+    case control::EVT_ERROR:
+        PLOGE("error %d : %s", result, payload.c_str());
+        break;
+    case control::EVT_JSON:
+        PLOGI("payload : %s", payload.c_str());
+        break;
+    default:
+        PLOGI("event %u", event);
+        break;
+    }
+}
+
+void MediaRecorder::releaseFinalized(const std::string &path)
+{
+    auto it = std::find_if(mFinalizing.begin(), mFinalizing.end(),
+                           [&path](const std::unique_ptr<finalizing_t> &f)
+                           { return f->path == path; });
+    if (it == mFinalizing.end())
+        return;
+
+    // The pipeline exits right after the notification, the main loop reaps it.
+    PLOGI("%s", path.c_str());
+    mFinalizing.erase(it);
+}
+
+void MediaRecorder::releaseExited()
+{
+    auto it = std::remove_if(mFinalizing.begin(), mFinalizing.end(),
+                             [](const std::unique_ptr<finalizing_t> &f)
+                             {
+                                 if (!f->channel->isClosed())
+                                     return false;
+                                 PLOGW("%s was not finalized", f->path.c_str());
+                                 return true;
+                             });
+    mFinalizing.erase(it, mFinalizing.end());
+}
+
+ErrorCode MediaRecorder::getRecordingStatus(json &status)
+{
+    if (state == CLOSE)
+    {
+        PLOGE("Invalid state %d", state);
+        return ERR_INVALID_STATE;
     }
 
+    std::lock_guard<std::mutex> lock(mStatusMutex);
+    status = mHasStatus ? toJson(mRecordingStatus) : json::object();
+    return ERR_NONE;
+}
+
+bool MediaRecorder::takeRecordingStatus(json *status)
+{
+    std::lock_guard<std::mutex> lock(mStatusMutex);
+    if (!mStatusPending)
+        return false;
+
+    if (status)
+        *status = toJson(mRecordingStatus);
+    mStatusPending = false;
     return true;
 }
 
@@ -591,7 +875,7 @@ ErrorCode MediaRecorder::setAudioFormat(std::string &audioCodec, uint32_t sample
         return ERR_AUDIO_NOT_OPENED;
     }
 
-    if (isSupportedAudioFormat(audioCodec, sampleRate, channels, bitRate) != ERR_NONE)
+    if (checkAudioFormat(audioCodec, sampleRate, channels, bitRate) != ERR_NONE)
     {
         return ERR_UNSUPPORTED_AUDIO_FORMAT;
     }
@@ -616,7 +900,14 @@ ErrorCode MediaRecorder::setAudioFormat(std::string &audioCodec, uint32_t sample
     return ERR_NONE;
 }
 
-ErrorCode MediaRecorder::setVideoFormat(std::string &videoCodec, unsigned int bitRate)
+ErrorCode MediaRecorder::checkAudioFormat(const std::string &audioCodec, uint32_t sampleRate,
+                                          uint32_t channels, uint32_t bitRate)
+{
+    return isSupportedAudioFormat(audioCodec, sampleRate, channels, bitRate);
+}
+
+ErrorCode MediaRecorder::setVideoFormat(std::string &videoCodec, unsigned int bitRate,
+                                        unsigned int minBitRate, unsigned int minFps)
 {
     PLOGI("");
     ErrorCode err = ERR_NONE;
@@ -642,7 +933,7 @@ ErrorCode MediaRecorder::setVideoFormat(std::string &videoCodec, unsigned int bi
         mVideoFormat.codec = videoCodec;
     }
 
-    if (bitRate >= 25000 && bitRate <= 25000000)
+    if (isSupportedVideoBitRate(bitRate))
     {
         mVideoFormat.bitRate = bitRate;
     }
@@ -651,11 +942,40 @@ ErrorCode MediaRecorder::setVideoFormat(std::string &videoCodec, unsigned int bi
         err = ERR_VIDEO_BITRATE_OUT_OF_RANGE;
     }
 
-    PLOGI("mVideoFormat: %s,  %d", mVideoFormat.codec.c_str(), mVideoFormat.bitRate);
+    // Lower bounds for the adaptive rate control, 0 keeps the value fixed.
+    if (minBitRate == 0 ||
+        (isSupportedVideoBitRate(minBitRate) && minBitRate <= mVideoFormat.bitRate))
+    {
+        mVideoFormat.minBitRate = minBitRate;
+    }
+    else
+    {
+        err = ERR_VIDEO_BITRATE_OUT_OF_RANGE;
+    }
+    mVideoFormat.minFps = minFps;
+
+    PLOGI("mVideoFormat: %s,  %d (min %d), min fps %d", mVideoFormat.codec.c_str(),
+          mVideoFormat.bitRate, mVideoFormat.minBitRate, mVideoFormat.minFps);
 
     return err;
 }
 
+ErrorCode MediaRecorder::checkVideoFormat(const std::string &videoCodec, unsigned int bitRate,
+                                          unsigned int minBitRate)
+{
+    if (!isSupportedVideoCodec(videoCodec))
+    {
+        return ERR_UNSUPPORTED_VIDEO_FORMAT;
+    }
+
+    if (!isSupportedVideoBitRate(bitRate) ||
+        (minBitRate != 0 && (!isSupportedVideoBitRate(minBitRate) || minBitRate > bitRate)))
+    {
+        return ERR_VIDEO_BITRATE_OUT_OF_RANGE;
+    }
+    return ERR_NONE;
+}
+
 ErrorCode MediaRecorder::pause()
 {
     PLOGI("");
@@ -667,28 +987,12 @@ ErrorCode MediaRecorder::pause()
     }
 
     // send message
-    std::string uri = record_uri + __func__;
-    PLOGI("%s '%s'", uri.c_str(), emptyJson);
-
-    std::string resp;
-    record_client->callSync(uri.c_str(), emptyJson, &resp);
-    PLOGI("resp %s", resp.c_str());
+    PLOGI("pause");
+    if (!record_channel->call(control::CMD_PAUSE))
+        return ERR_FAILED_TO_PAUSE;
 
-    try
-    {
-        json jOut = json::parse(resp);
-        if (get_optional<bool>(jOut, returnValueStr).value_or(false))
-        {
-            state = PAUSE;
-            return ERR_NONE;
-        }
-    }
-    catch (const json::exception &e)
-    {
-        PLOGE("Error occurred: %s", e.what());
-    }
-
-    return ERR_FAILED_TO_PAUSE;
+    state = PAUSE;
+    return ERR_NONE;
 }
 
 ErrorCode MediaRecorder::resume()
@@ -702,28 +1006,41 @@ ErrorCode MediaRecorder::resume()
     }
 
     // send message
-    std::string uri = record_uri + __func__;
-    PLOGI("%s '%s'", uri.c_str(), emptyJson);
+    PLOGI("resume");
+    if (!record_channel->call(control::CMD_RESUME))
+        return ERR_FAILED_TO_RESUME;
 
-    std::string resp;
-    record_client->callSync(uri.c_str(), emptyJson, &resp);
-    PLOGI("resp %s", resp.c_str());
+    // Play() asks the local parser only, behind shmsrc the shared encoder has to send one.
+    if (!mSharedHubKey.empty())
+        CaptureHub::getInstance().requestKeyFrame(mSharedHubKey);
+
+    state = RECORDING;
+    return ERR_NONE;
+}
+
+ErrorCode MediaRecorder::getStatistics(json &statistics)
+{
+    PLOGI("");
 
-    try
+    if (state != RECORDING && state != PAUSE)
     {
-        json jOut = json::parse(resp);
-        if (get_optional<bool>(jOut, returnValueStr).value_or(false))
-        {
-            state = RECORDING;
-            return ERR_NONE;
-        }
+        PLOGE("Invalid state %d", state);
+        return ERR_INVALID_STATE;
     }
-    catch (const json::exception &e)
+
+    // send message, the statistics come back as json
+    PLOGI("getStatistics");
+    std::string reply;
+    if (!record_channel->call(control::CMD_GET_STATISTICS, "", &reply))
+        return ERR_FAILED_TO_GET_STATISTICS;
+
+    statistics = json::parse(reply, nullptr, false);
+    if (statistics.is_discarded())
     {
-        PLOGE("Error occurred: %s", e.what());
+        PLOGE("statistics parsing fail!");
+        return ERR_FAILED_TO_GET_STATISTICS;
     }
-
-    return ERR_FAILED_TO_RESUME;
+    return ERR_NONE;
 }
 
 bool MediaRecorder::isSupportedExtension(const std::string &extension) const
@@ -733,7 +1050,9 @@ bool MediaRecorder::isSupportedExtension(const std::string &extension) const
                    ::tolower);
 
     return (lowercaseExtension == "mp4") || (lowercaseExtension == "m4a") ||
-           (lowercaseExtension == "jpg") || (lowercaseExtension == "jpeg");
+           (lowercaseExtension == "ogg") || (lowercaseExtension == "flac") ||
+           (lowercaseExtension == "wav") || (lowercaseExtension == "jpg") ||
+           (lowercaseExtension == "jpeg");
 }
 
 std::string MediaRecorder::createRecordFileName(const std::string &recordpath,
@@ -772,7 +1091,9 @@ std::string MediaRecorder::createRecordFileName(const std::string &recordpath,
         }
         else if (prefix == "Audio")
         {
-            ext = "m4a";
+            // m4a, ogg, flac or wav
+            ext = mFormat.empty() ? "m4a" : mFormat;
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
         }
         else if (prefix == "Capture")
         {
@@ -801,17 +1122,19 @@ std::string MediaRecorder::createRecordFileName(const std::string &recordpath,
     return path;
 }
 
-bool MediaRecorder::getCameraFormat()
+bool MediaRecorder::getCameraFormat() { return getCameraFormat(videoSrc, mVideoFormat); }
+
+bool MediaRecorder::getCameraFormat(const std::string &id, video_format_t &format)
 {
     // send message for getFormat
     json j;
-    j["id"] = videoSrc;
+    j["id"] = id;
 
     std::string uri = "luna://com.webos.service.camera2/getFormat";
     PLOGI("%s '%s'", uri.c_str(), to_string(j).c_str());
 
     std::string resp;
-    record_client->callSync(uri.c_str(), to_string(j).c_str(), &resp, 16000);
+    LSConnector::getInstance().callSync(uri.c_str(), to_string(j).c_str(), &resp, 16000);
     PLOGI("resp %s", resp.c_str());
 
     json jOut = json::parse(resp);
@@ -819,12 +1142,11 @@ bool MediaRecorder::getCameraFormat()
     {
         if (jOut.contains("params"))
         {
-            json params         = jOut["params"];
-            mVideoFormat.width  = get_optional<unsigned int>(params, "width").value_or(0);
-            mVideoFormat.height = get_optional<unsigned int>(params, "height").value_or(0);
-            mVideoFormat.fps    = get_optional<unsigned int>(params, "fps").value_or(0);
-            PLOGI("width=%d, height=%d, fps=%d", mVideoFormat.width, mVideoFormat.height,
-                  mVideoFormat.fps);
+            json params   = jOut["params"];
+            format.width  = get_optional<unsigned int>(params, "width").value_or(0);
+            format.height = get_optional<unsigned int>(params, "height").value_or(0);
+            format.fps    = get_optional<unsigned int>(params, "fps").value_or(0);
+            PLOGI("width=%d, height=%d, fps=%d", format.width, format.height, format.fps);
 
             return true;
         }
@@ -833,3 +1155,62 @@ bool MediaRecorder::getCameraFormat()
     PLOGE("Failed to get camera format");
     return false;
 }
+
+bool MediaRecorder::getCompositeLayout(json &composite)
+{
+    std::vector<std::string> srcs{videoSrc};
+    srcs.insert(srcs.end(), mCompositeSrcs.begin(), mCompositeSrcs.end());
+
+    // The output frame has the size of videoSrc. Regions are kept even for 4:2:0 formats.
+    unsigned int width  = mVideoFormat.width;
+    unsigned int height = mVideoFormat.height;
+    unsigned int cols   = 1;
+    while (cols * cols < srcs.size())
+        cols++;
+    unsigned int rows = (srcs.size() + cols - 1) / cols;
+
+    for (unsigned int i = 0; i < srcs.size(); i++)
+    {
+        video_format_t format = mVideoFormat;
+        if (i > 0 && !getCameraFormat(srcs[i], format))
+            return false;
+
+        unsigned int x = 0, y = 0, w = width, h = height;
+        if (mLayout == "tracks")
+        {
+            // every camera is a track of its own, encoded at its own size
+            w = format.width;
+            h = format.height;
+        }
+        else if (mLayout == "grid")
+        {
+            w = (width / cols) & ~1u;
+            h = (height / rows) & ~1u;
+            x = (i % cols) * w;
+            y = (i / cols) * h;
+        }
+        else if (i > 0)
+        {
+            // insets of a quarter of the frame, from the bottom right corner leftwards
+            w = (width / 4) & ~1u;
+            h = (height / 4) & ~1u;
+            x = width - (w + kCompositeMargin) * i;
+            y = height - h - kCompositeMargin;
+        }
+
+        auto src         = json::object();
+        src["videoSrc"]  = srcs[i];
+        src["width"]     = format.width;
+        src["height"]    = format.height;
+        src["x"]         = x;
+        src["y"]         = y;
+        src["outWidth"]  = w;
+        src["outHeight"] = h;
+        composite.push_back(std::move(src));
+
+        PLOGI("%s %ux%u -> %ux%u+%u+%u", srcs[i].c_str(), format.width, format.height, w, h, x,
+              y);
+    }
+
+    return true;
+}
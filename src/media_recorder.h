@@ -17,12 +17,16 @@
 #ifndef MEDIA_RECORDER_
 #define MEDIA_RECORDER_
 
+#include "control_protocol.h"
 #include "error.h"
 #include "format_utils.h"
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
 #include <vector>
 
-class LSConnector;
+class ControlChannel;
 class Process;
 class MediaRecorder
 {
@@ -41,49 +45,121 @@ class MediaRecorder
     std::string mFormat;
     std::string videoSrc;
     bool audioSrc = false;
-    State state   = CLOSE;
 
-    std::unique_ptr<LSConnector> record_client{nullptr};
-    std::unique_ptr<LSConnector> snapshot_client{nullptr};
+    // other cameras composited into the frame of videoSrc or recorded as tracks next to it
+    std::vector<std::string> mCompositeSrcs;
+    std::string mLayout;
+    State state = CLOSE;
+
+    // The channel is released before the process, so that a pipeline still recording sees
+    // it close and finalizes its file when the recorder goes away.
     std::unique_ptr<Process> record_process{nullptr};
-    std::string record_uri;
+    std::unique_ptr<ControlChannel> record_channel{nullptr};
+
+    // Recordings stopped but still finalized by their pipeline. The channel and the
+    // process are released once the pipeline notifies "finalized", or exits without it.
+    // They outlive close(), the manager keeps a closed recorder until they are released.
+    struct finalizing_t
+    {
+        std::string path;
+        std::unique_ptr<Process> process;
+        std::unique_ptr<ControlChannel> channel;
+    };
+    std::vector<std::unique_ptr<finalizing_t>> mFinalizing;
 
     video_format_t mVideoFormat{
         "H264", 1280, 720, 30,
         0}; // default vidoe format (video codec, width, height, fps, bitRate)
 
     audio_format_t mAudioFormat;
+
+    // live output sharing the recording encode
+    std::string mLiveType;
+    std::string mLivePath;
+    unsigned int mLivePort = 0;
+
+    // shared-memory socket carrying the encoded stream, empty when disabled
+    std::string mTapSocketPath;
+
+    // key of the CaptureHub hub shared with other recorders, empty when not shared
+    std::string mSharedHubKey;
+
     std::string mMediaId;
     bool mEos{false};
 
+    // Latest status from the record pipeline, kept until the manager takes it. It is made
+    // json only when read, not for every status.
+    std::mutex mStatusMutex;
+    control::recording_status_t mRecordingStatus{};
+    bool mHasStatus{false};
+    bool mStatusPending{false};
+    std::function<void(int)> statusNotifier_;
+    std::function<void(int, const nlohmann::json &)> finalizedNotifier_;
+    std::function<void(int)> exitNotifier_;
+
     bool isSupportedExtension(const std::string &) const;
     std::string createRecordFileName(const std::string &, const std::string &) const;
     bool getCameraFormat();
+    bool getCameraFormat(const std::string &id, video_format_t &format);
+    bool getCompositeLayout(nlohmann::json &composite);
 
 public:
     MediaRecorder();
     ~MediaRecorder();
 
-    ErrorCode open(std::string &video_src, bool audio_src);
+    ErrorCode open(std::string &video_src, bool audio_src,
+                   const std::vector<std::string> &composite_srcs = {},
+                   const std::string &layout                      = "pip");
     ErrorCode setOutputFile(std::string &path);
     ErrorCode setOutputFormat(std::string &format);
-    ErrorCode setVideoFormat(std::string &videoCodec, unsigned int bitRate);
+    ErrorCode setVideoFormat(std::string &videoCodec, unsigned int bitRate,
+                             unsigned int minBitRate = 0, unsigned int minFps = 0);
     ErrorCode setAudioFormat(std::string &audioCodec, unsigned int sampleRate,
                              unsigned int channels, unsigned int bitRate);
-    ErrorCode start();
+    ErrorCode setLiveOutput(std::string &type, unsigned int port, std::string &path);
+    ErrorCode start(unsigned int statusInterval = 1000, bool encodedTap = false,
+                    bool sharedCapture = false);
     ErrorCode stop();
     ErrorCode takeSnapshot(std::string &path, std::string &format);
     ErrorCode close();
     ErrorCode pause();
     ErrorCode resume();
+    ErrorCode getStatistics(nlohmann::json &statistics);
+    ErrorCode getRecordingStatus(nlohmann::json &status);
+    // Clears the pending status, status is filled if given.
+    bool takeRecordingStatus(nlohmann::json *status);
+    void setStatusNotifier(std::function<void(int)> notifier) { statusNotifier_ = notifier; }
+    void setFinalizedNotifier(std::function<void(int, const nlohmann::json &)> notifier)
+    {
+        finalizedNotifier_ = notifier;
+    }
+    void setExitNotifier(std::function<void(int)> notifier) { exitNotifier_ = notifier; }
+    void releaseFinalized(const std::string &path);
+    // Releases the recordings whose pipeline exited without notifying "finalized".
+    void releaseExited();
+    bool isFinalizing() const { return !mFinalizing.empty(); }
 
     int getRecorderId() { return recorderId; }
     std::string &getRecordPath() { return mRecordPath; }
     std::string &getCapturePath() { return mCapturePath; }
-    bool snapshotCb(const char *message);
+    std::string &getTapSocketPath() { return mTapSocketPath; }
+    void snapshotCb(uint16_t event);
+    void recordCb(uint16_t event, int32_t result, const std::string &payload);
+
+    // default audio format (audio codec, sampleRate, channels, bitRate)
+    static const audio_format_t mAudioFormatDefault;
 
-    audio_format_t const mAudioFormatDefault = {
-        "AAC", 44100, 2, 0}; // default audio format (audio codec, sampleRate, channels, bitRate)
+    // Checks of the set* methods that do not depend on the sources. Session profiles are
+    // validated with them before their sources are known.
+    static ErrorCode checkOutputFile(const std::string &path);
+    static ErrorCode checkOutputFormat(const std::string &format, bool video,
+                                       const std::string &audioCodec = "");
+    static ErrorCode checkVideoFormat(const std::string &videoCodec, unsigned int bitRate,
+                                      unsigned int minBitRate);
+    static ErrorCode checkAudioFormat(const std::string &audioCodec, uint32_t sampleRate,
+                                      uint32_t channels, uint32_t bitRate);
+    static ErrorCode checkLiveOutput(const std::string &type, unsigned int port,
+                                     const std::string &path);
 };
 
 #endif // MEDIA_RECORDER_
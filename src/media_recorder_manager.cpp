@@ -18,8 +18,10 @@
 #include "media_recorder_manager.h"
 #include "error.h"
 #include "error_manager.h"
+#include "flight_recorder.h"
 #include "json_utils.h"
 #include "log.h"
+#include "ls_connector.h"
 #include "media_recorder.h"
 #include <nlohmann/json.hpp>
 #include <string>
@@ -46,6 +48,168 @@ void handleJsonException(const std::exception &e, ErrorCode &error_code)
     }
 }
 
+// Opens a recorder on the sources of open, or of a session configuration
+static ErrorCode openRecorder(MediaRecorder &recorder, const json &j)
+{
+    std::string video_src = get_optional<std::string>(j, "video").value_or("");
+    bool audio_src        = get_optional<bool>(j, "audio").value_or(false);
+    std::string layout    = get_optional<std::string>(j, "layout").value_or("pip");
+
+    // Several cameras are composited into the frame of the first one
+    std::vector<std::string> composite_srcs;
+    if (auto videos = get_optional<std::vector<std::string>>(j, "video"))
+    {
+        if (!videos->empty())
+        {
+            video_src = videos->front();
+            composite_srcs.assign(videos->begin() + 1, videos->end());
+        }
+    }
+
+    return recorder.open(video_src, audio_src, composite_srcs, layout);
+}
+
+// Session configuration fields. Values left out take the defaults of the corresponding
+// set* methods.
+static video_format_t parseVideoFormat(const json &video)
+{
+    video_format_t format;
+    format.codec      = get_optional<std::string>(video, "codec").value_or("H264");
+    format.bitRate    = get_optional<unsigned int>(video, "bitRate").value_or(10000000);
+    format.minBitRate = get_optional<unsigned int>(video, "minBitRate").value_or(0);
+    format.minFps     = get_optional<unsigned int>(video, "minFps").value_or(0);
+    return format;
+}
+
+static audio_format_t parseAudioFormat(const json &audio)
+{
+    const audio_format_t &d = MediaRecorder::mAudioFormatDefault;
+    audio_format_t format;
+    format.codec      = get_optional<std::string>(audio, "codec").value_or(d.codec);
+    format.sampleRate = get_optional<uint32_t>(audio, "sampleRate").value_or(d.sampleRate);
+    format.channels   = get_optional<uint32_t>(audio, "channelCount").value_or(d.channels);
+    format.bitRate    = get_optional<uint32_t>(audio, "bitRate").value_or(d.bitRate);
+    return format;
+}
+
+struct live_output_t
+{
+    std::string type;
+    unsigned int port;
+    std::string path;
+};
+
+static live_output_t parseLiveOutput(const json &live)
+{
+    live_output_t output;
+    output.type = get_optional<std::string>(live, "type").value_or("none");
+    output.port = get_optional<unsigned int>(live, "port").value_or(5004);
+    output.path = get_optional<std::string>(live, "path").value_or("");
+    return output;
+}
+
+// Applies a whole session configuration to a new recorder, stopping at the first error.
+static ErrorCode configureRecorder(MediaRecorder &recorder, const json &config)
+{
+    ErrorCode error_code = openRecorder(recorder, config);
+    if (error_code != ERR_NONE)
+        return error_code;
+
+    if (auto value = get_optional<std::string>(config, "path"))
+    {
+        error_code = recorder.setOutputFile(*value);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    if (config.contains("videoFormat"))
+    {
+        video_format_t video = parseVideoFormat(config["videoFormat"]);
+        error_code           = recorder.setVideoFormat(video.codec, video.bitRate, video.minBitRate,
+                                                       video.minFps);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    if (config.contains("audioFormat"))
+    {
+        audio_format_t audio = parseAudioFormat(config["audioFormat"]);
+        error_code           = recorder.setAudioFormat(audio.codec, audio.sampleRate,
+                                                       audio.channels, audio.bitRate);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    if (config.contains("liveOutput"))
+    {
+        live_output_t live = parseLiveOutput(config["liveOutput"]);
+        error_code         = recorder.setLiveOutput(live.type, live.port, live.path);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    // last, the file format is checked against the sources
+    if (auto value = get_optional<std::string>(config, "format"))
+        error_code = recorder.setOutputFormat(*value);
+
+    return error_code;
+}
+
+// Checks a session profile with the checks of the set* methods. Its sources are usually
+// given with startSession, so the file format is checked against the kind of recording the
+// profile describes, or against both when it does not tell.
+static ErrorCode validateProfile(const json &profile)
+{
+    ErrorCode error_code = ERR_NONE;
+
+    if (auto value = get_optional<std::string>(profile, "path"))
+    {
+        error_code = MediaRecorder::checkOutputFile(*value);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    if (profile.contains("videoFormat"))
+    {
+        video_format_t video = parseVideoFormat(profile["videoFormat"]);
+        error_code = MediaRecorder::checkVideoFormat(video.codec, video.bitRate, video.minBitRate);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    std::string audioCodec;
+    if (profile.contains("audioFormat"))
+    {
+        audio_format_t audio = parseAudioFormat(profile["audioFormat"]);
+        error_code = MediaRecorder::checkAudioFormat(audio.codec, audio.sampleRate,
+                                                     audio.channels, audio.bitRate);
+        if (error_code != ERR_NONE)
+            return error_code;
+        audioCodec = audio.codec;
+    }
+
+    if (profile.contains("liveOutput"))
+    {
+        live_output_t live = parseLiveOutput(profile["liveOutput"]);
+        error_code         = MediaRecorder::checkLiveOutput(live.type, live.port, live.path);
+        if (error_code != ERR_NONE)
+            return error_code;
+    }
+
+    if (auto value = get_optional<std::string>(profile, "format"))
+    {
+        bool video = profile.contains("video") || profile.contains("videoFormat") ||
+                     profile.contains("liveOutput");
+        bool audio = get_optional<bool>(profile, "audio").value_or(false) ||
+                     profile.contains("audioFormat");
+        error_code = MediaRecorder::checkOutputFormat(*value, video || !audio, audioCodec);
+        if (error_code != ERR_NONE && !video && !audio)
+            error_code = MediaRecorder::checkOutputFormat(*value, false, audioCodec);
+    }
+
+    return error_code;
+}
+
 MediaRecorderManager::MediaRecorderManager() : LS::Handle(LS::registerService(service.c_str()))
 {
     LS_CATEGORY_BEGIN(MediaRecorderManager, "/")
@@ -55,13 +219,21 @@ MediaRecorderManager::MediaRecorderManager() : LS::Handle(LS::registerService(se
     LS_CATEGORY_METHOD(setOutputFormat)
     LS_CATEGORY_METHOD(setVideoFormat)
     LS_CATEGORY_METHOD(setAudioFormat)
+    LS_CATEGORY_METHOD(setLiveOutput)
     LS_CATEGORY_METHOD(start)
     LS_CATEGORY_METHOD(stop)
+    LS_CATEGORY_METHOD(startSession)
+    LS_CATEGORY_METHOD(setProfile)
     LS_CATEGORY_METHOD(takeSnapshot)
     LS_CATEGORY_METHOD(pause)
     LS_CATEGORY_METHOD(resume)
+    LS_CATEGORY_METHOD(getStatistics)
+    LS_CATEGORY_METHOD(getRecordingStatus)
     LS_CATEGORY_END;
 
+    // registered now rather than on the first start
+    LSConnector::getInstance();
+
     // attach to mainloop and run it
     attachToLoop(main_loop_ptr_.get());
 
@@ -75,18 +247,20 @@ bool MediaRecorderManager::open(LSMessage &message)
     int recorder_id      = 0;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
         json j = json::parse(payload);
 
-        std::string video_src = get_optional<std::string>(j, "video").value_or("");
-        bool audio_src        = get_optional<bool>(j, "audio").value_or(false);
-
         std::unique_ptr<MediaRecorder> recorder = std::make_unique<MediaRecorder>();
-        error_code                              = recorder->open(video_src, audio_src);
+        error_code                              = openRecorder(*recorder, j);
         if (error_code == ERR_NONE)
         {
+            recorder->setStatusNotifier([this](int id) { notifyRecordingStatus(id); });
+            recorder->setFinalizedNotifier([this](int id, const json &finalized)
+                                           { notifyFinalized(id, finalized); });
+            recorder->setExitNotifier([this](int id) { notifyExit(id); });
             recorder_id            = recorder->getRecorderId();
             recorders[recorder_id] = std::move(recorder);
             printRecorders();
@@ -116,6 +290,7 @@ bool MediaRecorderManager::open(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -128,6 +303,7 @@ bool MediaRecorderManager::close(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -153,6 +329,9 @@ bool MediaRecorderManager::close(LSMessage &message)
         error_code = recorders[recorder_id]->close();
         if (error_code == ERR_NONE)
         {
+            // its finalized notifications are still sent to subscribers
+            if (recorders[recorder_id]->isFinalizing())
+                closingRecorders[recorder_id] = std::move(recorders[recorder_id]);
             recorders.erase(recorder_id);
             printRecorders();
         }
@@ -180,6 +359,7 @@ bool MediaRecorderManager::close(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -192,6 +372,7 @@ bool MediaRecorderManager::setOutputFile(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -248,6 +429,7 @@ bool MediaRecorderManager::setOutputFile(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -260,6 +442,7 @@ bool MediaRecorderManager::setOutputFormat(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -316,6 +499,7 @@ bool MediaRecorderManager::setOutputFormat(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -328,6 +512,7 @@ bool MediaRecorderManager::setVideoFormat(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -354,7 +539,12 @@ bool MediaRecorderManager::setVideoFormat(LSMessage &message)
         std::string videoCodec = get_optional<std::string>(j, "codec").value_or("H264");
         unsigned int bitRate   = get_optional<unsigned int>(j, "bitRate").value_or(10000000);
 
-        error_code = recorders[recorder_id]->setVideoFormat(videoCodec, bitRate);
+        // Optional lower bounds for adapting to a slow encoder or storage
+        unsigned int minBitRate = get_optional<unsigned int>(j, "minBitRate").value_or(0);
+        unsigned int minFps     = get_optional<unsigned int>(j, "minFps").value_or(0);
+
+        error_code =
+            recorders[recorder_id]->setVideoFormat(videoCodec, bitRate, minBitRate, minFps);
     }
     catch (const std::exception &e)
     {
@@ -379,6 +569,7 @@ bool MediaRecorderManager::setVideoFormat(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -391,6 +582,7 @@ bool MediaRecorderManager::setAudioFormat(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -449,6 +641,73 @@ bool MediaRecorderManager::setAudioFormat(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
+
+    LS::Message request(&message);
+    request.respond(respStr.c_str());
+
+    return true;
+}
+
+bool MediaRecorderManager::setLiveOutput(LSMessage &message)
+{
+    ErrorCode error_code = ERR_LIST_END;
+    auto *payload        = LSMessageGetPayload(&message);
+    PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
+
+    try
+    {
+        json j = json::parse(payload);
+
+        int recorder_id = 0;
+        if (auto value = get_optional<int>(j, "recorderId"))
+        {
+            recorder_id = *value;
+        }
+        else
+        {
+            error_code = ERR_RECORDER_ID_NOT_SPECIFIED;
+            throw std::invalid_argument("Parameter is missing");
+        }
+
+        if (recorders.find(recorder_id) == recorders.end())
+        {
+            error_code = ERR_INVALID_RECORDER_ID;
+            throw std::invalid_argument("Parameter is invalid");
+        }
+
+        // Live output
+        std::string type  = get_optional<std::string>(j, "type").value_or("none");
+        unsigned int port = get_optional<unsigned int>(j, "port").value_or(5004);
+        std::string path  = get_optional<std::string>(j, "path").value_or("");
+
+        error_code = recorders[recorder_id]->setLiveOutput(type, port, path);
+    }
+    catch (const std::exception &e)
+    {
+        handleJsonException(e, error_code);
+    }
+
+    json resp;
+    if (error_code == ERR_NONE)
+    {
+        resp["returnValue"] = true;
+    }
+    else
+    {
+        resp["returnValue"] = false;
+
+        Error error       = ErrorManager::getInstance().getError(error_code);
+        resp["errorCode"] = error.getCode();
+        resp["errorText"] = error.getMessage();
+
+        PLOGE("%d %s", error.getCode(), error.getMessage().c_str());
+    }
+
+    std::string respStr = to_string(resp);
+    PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -461,6 +720,9 @@ bool MediaRecorderManager::start(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
+
+    std::string tap_socket_path;
 
     try
     {
@@ -483,7 +745,16 @@ bool MediaRecorderManager::start(LSMessage &message)
             throw std::invalid_argument("Parameter is invalid");
         }
 
-        error_code = recorders[recorder_id]->start();
+        unsigned int status_interval =
+            get_optional<unsigned int>(j, "statusInterval").value_or(1000);
+        bool encoded_tap    = get_optional<bool>(j, "encodedTap").value_or(false);
+        bool shared_capture = get_optional<bool>(j, "sharedCapture").value_or(false);
+
+        error_code = recorders[recorder_id]->start(status_interval, encoded_tap, shared_capture);
+        if (error_code == ERR_NONE)
+        {
+            tap_socket_path = recorders[recorder_id]->getTapSocketPath();
+        }
     }
     catch (const std::exception &e)
     {
@@ -494,6 +765,10 @@ bool MediaRecorderManager::start(LSMessage &message)
     if (error_code == ERR_NONE)
     {
         resp["returnValue"] = true;
+        if (!tap_socket_path.empty())
+        {
+            resp["tapSocketPath"] = tap_socket_path;
+        }
     }
     else
     {
@@ -508,6 +783,167 @@ bool MediaRecorderManager::start(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
+
+    LS::Message request(&message);
+    request.respond(respStr.c_str());
+
+    return true;
+}
+
+bool MediaRecorderManager::startSession(LSMessage &message)
+{
+    ErrorCode error_code = ERR_LIST_END;
+    auto *payload        = LSMessageGetPayload(&message);
+    PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
+
+    int recorder_id = 0;
+    std::string path;
+    std::string tap_socket_path;
+
+    try
+    {
+        json j = json::parse(payload);
+
+        // The keys of the request override those of the profile
+        json config = json::object();
+        if (auto name = get_optional<std::string>(j, "profile"))
+        {
+            auto it = profiles.find(*name);
+            if (it == profiles.end())
+            {
+                error_code = ERR_PROFILE_NOT_FOUND;
+                throw std::invalid_argument("Parameter is invalid");
+            }
+            config = it->second;
+            j.erase("profile");
+        }
+        config.merge_patch(j);
+
+        std::unique_ptr<MediaRecorder> recorder = std::make_unique<MediaRecorder>();
+        error_code                              = configureRecorder(*recorder, config);
+        if (error_code == ERR_NONE)
+        {
+            unsigned int status_interval =
+                get_optional<unsigned int>(config, "statusInterval").value_or(1000);
+            bool encoded_tap    = get_optional<bool>(config, "encodedTap").value_or(false);
+            bool shared_capture = get_optional<bool>(config, "sharedCapture").value_or(false);
+
+            recorder->setStatusNotifier([this](int id) { notifyRecordingStatus(id); });
+            recorder->setFinalizedNotifier([this](int id, const json &finalized)
+                                           { notifyFinalized(id, finalized); });
+            recorder->setExitNotifier([this](int id) { notifyExit(id); });
+            error_code = recorder->start(status_interval, encoded_tap, shared_capture);
+        }
+
+        if (error_code == ERR_NONE)
+        {
+            recorder_id            = recorder->getRecorderId();
+            path                   = recorder->getRecordPath();
+            tap_socket_path        = recorder->getTapSocketPath();
+            recorders[recorder_id] = std::move(recorder);
+            printRecorders();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        handleJsonException(e, error_code);
+    }
+
+    json resp;
+    if (error_code == ERR_NONE)
+    {
+        resp["returnValue"] = true;
+        resp["recorderId"]  = recorder_id;
+        resp["path"]        = path;
+        if (!tap_socket_path.empty())
+        {
+            resp["tapSocketPath"] = tap_socket_path;
+        }
+    }
+    else
+    {
+        resp["returnValue"] = false;
+
+        Error error       = ErrorManager::getInstance().getError(error_code);
+        resp["errorCode"] = error.getCode();
+        resp["errorText"] = error.getMessage();
+
+        PLOGE("%d %s", error.getCode(), error.getMessage().c_str());
+    }
+
+    std::string respStr = to_string(resp);
+    PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
+
+    LS::Message request(&message);
+    request.respond(respStr.c_str());
+
+    return true;
+}
+
+bool MediaRecorderManager::setProfile(LSMessage &message)
+{
+    ErrorCode error_code = ERR_LIST_END;
+    auto *payload        = LSMessageGetPayload(&message);
+    PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
+
+    try
+    {
+        json j = json::parse(payload);
+
+        std::string name = get_optional<std::string>(j, "name").value_or("");
+        if (name.empty())
+        {
+            error_code = ERR_PROFILE_NOT_SPECIFIED;
+            throw std::invalid_argument("Parameter is missing");
+        }
+
+        // Without a configuration the profile is removed
+        if (!j.contains("profile") || j["profile"].is_null())
+        {
+            error_code = profiles.erase(name) ? ERR_NONE : ERR_PROFILE_NOT_FOUND;
+        }
+        else
+        {
+            const json &profile = j["profile"];
+            if (!profile.is_object())
+            {
+                error_code = ERR_JSON_TYPE;
+                throw std::invalid_argument("Parameter is invalid");
+            }
+
+            error_code = validateProfile(profile);
+            if (error_code == ERR_NONE)
+                profiles[name] = profile;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        handleJsonException(e, error_code);
+    }
+
+    json resp;
+    if (error_code == ERR_NONE)
+    {
+        resp["returnValue"] = true;
+    }
+    else
+    {
+        resp["returnValue"] = false;
+
+        Error error       = ErrorManager::getInstance().getError(error_code);
+        resp["errorCode"] = error.getCode();
+        resp["errorText"] = error.getMessage();
+
+        PLOGE("%d %s", error.getCode(), error.getMessage().c_str());
+    }
+
+    std::string respStr = to_string(resp);
+    PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -520,6 +956,7 @@ bool MediaRecorderManager::stop(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     int recorder_id = 0;
 
@@ -568,6 +1005,7 @@ bool MediaRecorderManager::stop(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -580,6 +1018,7 @@ bool MediaRecorderManager::takeSnapshot(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     int recorder_id = 0;
 
@@ -649,6 +1088,7 @@ bool MediaRecorderManager::takeSnapshot(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -661,6 +1101,7 @@ bool MediaRecorderManager::pause(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -708,6 +1149,7 @@ bool MediaRecorderManager::pause(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -720,6 +1162,7 @@ bool MediaRecorderManager::resume(LSMessage &message)
     ErrorCode error_code = ERR_LIST_END;
     auto *payload        = LSMessageGetPayload(&message);
     PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
 
     try
     {
@@ -767,6 +1210,7 @@ bool MediaRecorderManager::resume(LSMessage &message)
 
     std::string respStr = to_string(resp);
     PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
 
     LS::Message request(&message);
     request.respond(respStr.c_str());
@@ -774,6 +1218,285 @@ bool MediaRecorderManager::resume(LSMessage &message)
     return true;
 }
 
+bool MediaRecorderManager::getStatistics(LSMessage &message)
+{
+    ErrorCode error_code = ERR_LIST_END;
+    auto *payload        = LSMessageGetPayload(&message);
+    PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
+
+    json statistics;
+
+    try
+    {
+        json j = json::parse(payload);
+
+        int recorder_id = 0;
+        if (auto value = get_optional<int>(j, "recorderId"))
+        {
+            recorder_id = *value;
+        }
+        else
+        {
+            error_code = ERR_RECORDER_ID_NOT_SPECIFIED;
+            throw std::invalid_argument("Parameter is missing");
+        }
+
+        if (recorders.find(recorder_id) == recorders.end())
+        {
+            error_code = ERR_INVALID_RECORDER_ID;
+            throw std::invalid_argument("Parameter is invalid");
+        }
+
+        error_code = recorders[recorder_id]->getStatistics(statistics);
+    }
+    catch (const std::exception &e)
+    {
+        handleJsonException(e, error_code);
+    }
+
+    json resp;
+    if (error_code == ERR_NONE)
+    {
+        resp["returnValue"] = true;
+        resp["statistics"]  = std::move(statistics);
+    }
+    else
+    {
+        resp["returnValue"] = false;
+
+        Error error       = ErrorManager::getInstance().getError(error_code);
+        resp["errorCode"] = error.getCode();
+        resp["errorText"] = error.getMessage();
+
+        PLOGE("%d %s", error.getCode(), error.getMessage().c_str());
+    }
+
+    std::string respStr = to_string(resp);
+    PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
+
+    LS::Message request(&message);
+    request.respond(respStr.c_str());
+
+    return true;
+}
+
+bool MediaRecorderManager::getRecordingStatus(LSMessage &message)
+{
+    ErrorCode error_code = ERR_LIST_END;
+    auto *payload        = LSMessageGetPayload(&message);
+    PLOGI("payload %s", payload);
+    flight::record(flight::EV_API_CALL, 0, 0, __FUNCTION__);
+
+    int recorder_id = 0;
+    bool subscribed = false;
+    json status;
+
+    try
+    {
+        json j = json::parse(payload);
+
+        if (auto value = get_optional<int>(j, "recorderId"))
+        {
+            recorder_id = *value;
+        }
+        else
+        {
+            error_code = ERR_RECORDER_ID_NOT_SPECIFIED;
+            throw std::invalid_argument("Parameter is missing");
+        }
+
+        if (recorders.find(recorder_id) == recorders.end())
+        {
+            error_code = ERR_INVALID_RECORDER_ID;
+            throw std::invalid_argument("Parameter is invalid");
+        }
+
+        error_code = recorders[recorder_id]->getRecordingStatus(status);
+
+        if (error_code == ERR_NONE && LSMessageIsSubscription(&message))
+        {
+            std::string key = std::string(__func__) + "/" + std::to_string(recorder_id);
+
+            LSError lserror;
+            LSErrorInit(&lserror);
+            subscribed = LSSubscriptionAdd(this->get(), key.c_str(), &message, &lserror);
+            if (!subscribed)
+            {
+                LSErrorPrint(&lserror, stderr);
+                LSErrorFree(&lserror);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        handleJsonException(e, error_code);
+    }
+
+    json resp;
+    if (error_code == ERR_NONE)
+    {
+        resp["returnValue"]     = true;
+        resp["subscribed"]      = subscribed;
+        resp["recorderId"]      = recorder_id;
+        resp["recordingStatus"] = std::move(status);
+    }
+    else
+    {
+        resp["returnValue"] = false;
+
+        Error error       = ErrorManager::getInstance().getError(error_code);
+        resp["errorCode"] = error.getCode();
+        resp["errorText"] = error.getMessage();
+
+        PLOGE("%d %s", error.getCode(), error.getMessage().c_str());
+    }
+
+    std::string respStr = to_string(resp);
+    PLOGI("reply %s", respStr.c_str());
+    flight::record(flight::EV_API_REPLY, error_code, 0, __FUNCTION__);
+
+    LS::Message request(&message);
+    request.respond(respStr.c_str());
+
+    return true;
+}
+
+void MediaRecorderManager::notifyRecordingStatus(int recorder_id)
+{
+    // Called on the read thread of the recorder's ControlChannel. Subscription replies go out
+    // from the main loop.
+    auto *data = new std::pair<MediaRecorderManager *, int>(this, recorder_id);
+    g_idle_add(
+        +[](gpointer user_data) -> gboolean
+        {
+            std::unique_ptr<std::pair<MediaRecorderManager *, int>> data(
+                static_cast<std::pair<MediaRecorderManager *, int> *>(user_data));
+            data->first->replyRecordingStatus(data->second);
+            return G_SOURCE_REMOVE;
+        },
+        data);
+}
+
+void MediaRecorderManager::replyRecordingStatus(int recorder_id)
+{
+    auto it = recorders.find(recorder_id);
+    if (it == recorders.end())
+        return;
+
+    // The pending status is taken either way, it is made json only for subscribers.
+    std::string key = "getRecordingStatus/" + std::to_string(recorder_id);
+    bool subscribed = LSSubscriptionGetHandleSubscribersCount(this->get(), key.c_str()) > 0;
+
+    json status;
+    if (!it->second->takeRecordingStatus(subscribed ? &status : nullptr) || !subscribed)
+        return;
+
+    json resp;
+    resp["returnValue"]     = true;
+    resp["subscribed"]      = true;
+    resp["recorderId"]      = recorder_id;
+    resp["recordingStatus"] = std::move(status);
+
+    LSError lserror;
+    LSErrorInit(&lserror);
+    if (!LSSubscriptionReply(this->get(), key.c_str(), to_string(resp).c_str(), &lserror))
+    {
+        LSErrorPrint(&lserror, stderr);
+        LSErrorFree(&lserror);
+    }
+}
+
+void MediaRecorderManager::notifyFinalized(int recorder_id, const json &finalized)
+{
+    // Called on the ControlChannel read thread of the stopped recording. The reply goes out
+    // from the main loop.
+    struct finalized_data_t
+    {
+        MediaRecorderManager *manager;
+        int recorderId;
+        json finalized;
+    };
+    g_idle_add(
+        +[](gpointer user_data) -> gboolean
+        {
+            std::unique_ptr<finalized_data_t> data(static_cast<finalized_data_t *>(user_data));
+            data->manager->replyFinalized(data->recorderId, data->finalized);
+            return G_SOURCE_REMOVE;
+        },
+        new finalized_data_t{this, recorder_id, finalized});
+}
+
+void MediaRecorderManager::replyFinalized(int recorder_id, const json &finalized)
+{
+    MediaRecorder *recorder = findRecorder(recorder_id);
+    if (!recorder)
+        return;
+
+    std::string key = "getRecordingStatus/" + std::to_string(recorder_id);
+    if (LSSubscriptionGetHandleSubscribersCount(this->get(), key.c_str()) > 0)
+    {
+        json resp;
+        resp["returnValue"] = true;
+        resp["subscribed"]  = true;
+        resp["recorderId"]  = recorder_id;
+        resp["finalized"]   = {{"path", finalized.value("path", "")},
+                               {"duration", finalized.value("duration", (uint64_t)0)},
+                               {"size", finalized.value("size", (uint64_t)0)}};
+
+        LSError lserror;
+        LSErrorInit(&lserror);
+        if (!LSSubscriptionReply(this->get(), key.c_str(), to_string(resp).c_str(), &lserror))
+        {
+            LSErrorPrint(&lserror, stderr);
+            LSErrorFree(&lserror);
+        }
+    }
+
+    recorder->releaseFinalized(finalized.value("path", ""));
+    releaseClosing(recorder_id);
+}
+
+void MediaRecorderManager::notifyExit(int recorder_id)
+{
+    // Called on the channel thread of an exited pipeline, released from the main loop.
+    auto *data = new std::pair<MediaRecorderManager *, int>(this, recorder_id);
+    g_idle_add(
+        +[](gpointer user_data) -> gboolean
+        {
+            std::unique_ptr<std::pair<MediaRecorderManager *, int>> data(
+                static_cast<std::pair<MediaRecorderManager *, int> *>(user_data));
+            if (MediaRecorder *recorder = data->first->findRecorder(data->second))
+            {
+                recorder->releaseExited();
+                data->first->releaseClosing(data->second);
+            }
+            return G_SOURCE_REMOVE;
+        },
+        data);
+}
+
+MediaRecorder *MediaRecorderManager::findRecorder(int recorder_id)
+{
+    auto it = recorders.find(recorder_id);
+    if (it != recorders.end())
+        return it->second.get();
+
+    it = closingRecorders.find(recorder_id);
+    return (it != closingRecorders.end()) ? it->second.get() : nullptr;
+}
+
+void MediaRecorderManager::releaseClosing(int recorder_id)
+{
+    auto it = closingRecorders.find(recorder_id);
+    if (it != closingRecorders.end() && !it->second->isFinalizing())
+    {
+        PLOGI("closed recorder %d released", recorder_id);
+        closingRecorders.erase(it);
+    }
+}
+
 void MediaRecorderManager::printRecorders()
 {
     int index = 0;
@@ -787,6 +1510,8 @@ void MediaRecorderManager::printRecorders()
 
 int main(int argc, char *argv[])
 {
+    flight::scope_t flightRing("service");
+
     try
     {
         MediaRecorderManager mediaRecordService;
@@ -21,6 +21,7 @@
 #include <glib.h>
 #include <map>
 #include <memory>
+#include <nlohmann/json.hpp>
 
 class MediaRecorder;
 class MediaRecorderManager : public LS::Handle
@@ -30,6 +31,20 @@ class MediaRecorderManager : public LS::Handle
 
     std::map<int, std::unique_ptr<MediaRecorder>> recorders;
 
+    // closed recorders kept until their last recording is finalized
+    std::map<int, std::unique_ptr<MediaRecorder>> closingRecorders;
+
+    // named session configurations for startSession, validated when set
+    std::map<std::string, nlohmann::json> profiles;
+
+    void notifyRecordingStatus(int recorder_id);
+    void replyRecordingStatus(int recorder_id);
+    void notifyFinalized(int recorder_id, const nlohmann::json &finalized);
+    void replyFinalized(int recorder_id, const nlohmann::json &finalized);
+    void notifyExit(int recorder_id);
+    MediaRecorder *findRecorder(int recorder_id);
+    void releaseClosing(int recorder_id);
+
 public:
     MediaRecorderManager();
 
@@ -44,11 +59,16 @@ public:
     bool setOutputFormat(LSMessage &message);
     bool setVideoFormat(LSMessage &message);
     bool setAudioFormat(LSMessage &message);
+    bool setLiveOutput(LSMessage &message);
     bool start(LSMessage &message);
     bool stop(LSMessage &message);
+    bool startSession(LSMessage &message);
+    bool setProfile(LSMessage &message);
     bool takeSnapshot(LSMessage &message);
     bool pause(LSMessage &message);
     bool resume(LSMessage &message);
+    bool getStatistics(LSMessage &message);
+    bool getRecordingStatus(LSMessage &message);
 
     void printRecorders(); //[TODO] Remove this for debugging purpose.
 };
@@ -16,17 +16,20 @@
 
 #define LOG_TAG "Process"
 #include "process.h"
+#include "flight_recorder.h"
 #include "log.h"
-#include <iterator>
-#include <sstream>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
 #include <sys/wait.h>
-#include <vector>
 
-Process::Process(const std::string &cmd)
+extern char **environ;
+
+Process::Process(const std::vector<std::string> &argv, int controlFd)
 {
     PLOGI("");
 
-    start(cmd);
+    start(argv, controlFd);
 }
 
 Process::~Process()
@@ -36,51 +39,97 @@ Process::~Process()
     stop();
 }
 
-void Process::start(const std::string &cmd)
+void Process::start(const std::vector<std::string> &argv, int controlFd)
 {
-    PLOGI("%s", cmd.c_str());
+    if (argv.empty())
+        return;
+    PLOGI("%s", argv[0].c_str());
+
+    std::vector<char *> args;
+    for (const auto &arg : argv)
+        args.push_back(const_cast<char *>(arg.c_str()));
+    args.push_back(nullptr);
+
+    // dup2 onto kControlFd clears close-on-exec there, unless it is that descriptor already
+    int fd = controlFd;
+    if (fd == kControlFd)
+        fd = fcntl(controlFd, F_DUPFD_CLOEXEC, kControlFd + 1);
 
-    _pid = fork();
-    if (_pid == 0)
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (fd >= 0)
+        posix_spawn_file_actions_adddup2(&actions, fd, kControlFd);
+
+    int err = posix_spawn(&_pid, args[0], &actions, nullptr, args.data(), environ);
+    if (err != 0)
     {
-        std::istringstream iss(cmd);
-        std::vector<std::string> tokens{std::istream_iterator<std::string>{iss},
-                                        std::istream_iterator<std::string>{}};
-        size_t tokens_size = (tokens.size() < (SIZE_MAX)) ? tokens.size() + 1 : tokens.size();
-        char **argv = new char *[(tokens_size < (SIZE_MAX / sizeof(char *))) ? tokens_size : 0];
-        size_t v    = 0;
-        for (const auto &token : tokens)
-        {
-            size_t token_size = (token.size() < SIZE_MAX) ? token.size() + 1 : token.size();
-            argv[v]           = new char[token_size];
-            strncpy(argv[(v < SIZE_MAX) ? v++ : v], token.c_str(), token_size);
-        }
-        argv[v] = nullptr;
-        execv(argv[0], argv);
-        _exit(0);
+        PLOGE("posix_spawn error : %d", err);
+        _pid = -1;
     }
+    posix_spawn_file_actions_destroy(&actions);
+    flight::record(flight::EV_SPAWN, _pid, 0, basename(args[0]));
+
+    if (fd != controlFd && fd >= 0)
+        close(fd);
+
+    PLOGI("pid %d", _pid);
 }
+
 void Process::stop()
 {
+    if (_pid <= 0)
+        return;
     PLOGI("pid %d", _pid);
 
-    int status    = 0;
-    pid_t waitPid = wait(&status);
-    if (waitPid == -1)
+    // Reaped on the main loop. The timer kills a child that does not exit on its own.
+    struct reap_t
     {
-        PLOGE("error : %d", errno);
-    }
-    else
-    {
-        if (WIFEXITED(status))
+        pid_t pid;
+        guint timer;
+    };
+    auto *reap = new reap_t{_pid, 0};
+
+    reap->timer = g_timeout_add(
+        kKillTimeout,
+        +[](gpointer data) -> gboolean
         {
-            PLOGI("normal exit status %d", WEXITSTATUS(status));
-        }
-        else if (WIFSIGNALED(status))
+            auto *reap = static_cast<reap_t *>(data);
+            PLOGE("pid %d did not exit, killing it", reap->pid);
+            kill(reap->pid, SIGKILL);
+            reap->timer = 0;
+            return G_SOURCE_REMOVE;
+        },
+        reap);
+
+    g_child_watch_add(
+        _pid,
+        +[](GPid pid, gint status, gpointer data)
         {
-            PLOGI("abnormal exit status %d", WTERMSIG(status));
-        }
-    }
+            auto *reap = static_cast<reap_t *>(data);
+            flight::record(flight::EV_EXIT, pid, status);
+            if (WIFEXITED(status))
+            {
+                PLOGI("pid %d normal exit status %d", pid, WEXITSTATUS(status));
 
-    PLOGI("end pid %d", waitPid);
-}
\ No newline at end of file
+                // a ring is only left behind if it failed without closing it, or if a fatal
+                // signal handler wrote it and exited
+                if (WEXITSTATUS(status) != 0)
+                    flight::collect(pid, "failed");
+            }
+            else if (WIFSIGNALED(status))
+            {
+                PLOGI("pid %d abnormal exit status %d", pid, WTERMSIG(status));
+
+                // the ring it left behind tells what it was doing
+                flight::collect(pid, (WTERMSIG(status) == SIGKILL) ? "killed" : "crashed");
+            }
+
+            if (reap->timer)
+                g_source_remove(reap->timer);
+            g_spawn_close_pid(pid);
+            delete reap;
+        },
+        reap);
+
+    _pid = -1;
+}
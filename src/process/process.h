@@ -18,15 +18,30 @@
 #include <glib.h>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
+/**
+ * Child process started with posix_spawn.
+ * It is not waited for when released: the main loop reaps it, by its pid only, and kills
+ * it if it has not exited within kKillTimeout.
+ */
 class Process
 {
-    pid_t _pid;
+    pid_t _pid = -1;
 
-    void start(const std::string &cmd);
+    void start(const std::vector<std::string> &argv, int controlFd);
     void stop();
 
 public:
-    Process(const std::string &cmd);
+    // descriptor controlFd becomes in the child
+    static const int kControlFd = 3;
+
+    // ms a released child has to exit before it is killed
+    static const guint kKillTimeout = 30000;
+
+    Process(const std::vector<std::string> &argv, int controlFd = -1);
     ~Process();
-};
+
+    Process(Process const &)            = delete;
+    Process &operator=(Process const &) = delete;
+};
\ No newline at end of file
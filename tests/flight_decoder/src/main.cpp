@@ -0,0 +1,215 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "flight_recorder.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct entry_t
+{
+    uint64_t seq;
+    uint64_t time;
+    uint64_t a;
+    uint64_t b;
+    uint32_t tid;
+    uint16_t event;
+    std::string text;
+    std::string process; // <name>:<pid>
+    uint64_t realtimeBase;
+    uint64_t monotonicBase;
+};
+
+static const char *kEvents[] = {"",      "API_CALL", "API_REPLY", "COMMAND", "NOTIFY",
+                                "STATE", "BUS",      "BUFFERS",   "ERROR",   "TIMEOUT",
+                                "SPAWN", "EXIT",     "SIGNAL",    "DUMP"};
+
+// control::command_t
+static const char *kCommands[] = {"",       "START",          "STOP",
+                                  "PAUSE",  "RESUME",         "GET_STATISTICS",
+                                  "REQUEST_KEY_FRAME"};
+
+// control::event_t
+static const char *kNotifications[] = {"",        "RECORDING_STATUS", "FINALIZED",
+                                       "END_OF_STREAM", "ERROR",    "LOAD_COMPLETED",
+                                       "UNLOAD_COMPLETED", "PLAYING", "PAUSED", "JSON"};
+
+// GstState
+static const char *kStates[] = {"VOID_PENDING", "NULL", "READY", "PAUSED", "PLAYING"};
+
+template <size_t N>
+static const char *name(const char *(&names)[N], uint64_t value)
+{
+    return (value < N && names[value][0]) ? names[value] : "?";
+}
+
+// GstMessageType, a single bit each
+static std::string messageName(uint64_t type)
+{
+    static const char *names[] = {
+        "eos",           "error",         "warning",          "info",        "tag",
+        "buffering",     "state-changed", "state-dirty",      "step-done",   "clock-provide",
+        "clock-lost",    "new-clock",     "structure-change", "stream-status",
+        "application",   "element",       "segment-start",    "segment-done",
+        "duration-changed", "latency",    "async-start",      "async-done",
+        "request-state", "step-start",    "qos",              "progress",    "toc",
+        "reset-time",    "stream-start",  "need-context",     "have-context"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (type == (1ull << i))
+            return names[i];
+    }
+    char hex[24];
+    snprintf(hex, sizeof(hex), "0x%" PRIx64, type);
+    return hex;
+}
+
+static bool load(const char *path, std::vector<entry_t> &entries)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        printf("%s : cannot open\n", path);
+        return false;
+    }
+
+    auto ring = std::make_unique<flight::ring_t>();
+    file.read(reinterpret_cast<char *>(ring.get()), sizeof(flight::ring_t));
+    if (file.gcount() != (std::streamsize)sizeof(flight::ring_t) ||
+        ring->magic != flight::kMagic || ring->version != flight::kVersion ||
+        ring->recordSize != sizeof(flight::record_t) || ring->capacity != flight::kCapacity)
+    {
+        printf("%s : not a flight recorder ring of this version\n", path);
+        return false;
+    }
+
+    std::string process = std::string(ring->name, strnlen(ring->name, sizeof(ring->name))) +
+                          ":" + std::to_string(ring->pid);
+    uint64_t head       = ring->head.load();
+    size_t count        = 0;
+    for (uint32_t i = 0; i < flight::kCapacity; i++)
+    {
+        const flight::record_t &r = ring->records[i];
+        uint64_t seq              = r.seq.load();
+
+        // empty, torn by a writer, or a stale slot of an older lap
+        if (seq == 0 || seq > head || ((seq - 1) & (flight::kCapacity - 1)) != i)
+            continue;
+
+        entries.push_back({seq, r.time, r.a, r.b, r.tid, r.event,
+                           std::string(r.text, strnlen(r.text, sizeof(r.text))), process,
+                           ring->realtimeBase, ring->monotonicBase});
+        count++;
+    }
+
+    printf("%s : %s, %zu records, %" PRIu64 " recorded in total\n", path, process.c_str(),
+           count, head);
+    return true;
+}
+
+static void print(const entry_t &e)
+{
+    // wall clock from the base the ring was opened at
+    uint64_t realtime = e.realtimeBase + (e.time - e.monotonicBase);
+    time_t seconds    = realtime / 1000000000;
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    char clock[16];
+    strftime(clock, sizeof(clock), "%H:%M:%S", &tm);
+
+    char details[128];
+    const char *text = e.text.c_str();
+    switch (e.event)
+    {
+    case flight::EV_API_CALL:
+    case flight::EV_DUMP:
+        snprintf(details, sizeof(details), "%s", text);
+        break;
+    case flight::EV_API_REPLY:
+        snprintf(details, sizeof(details), "%s errorCode %" PRId64, text, (int64_t)e.a);
+        break;
+    case flight::EV_COMMAND:
+        snprintf(details, sizeof(details), "%s %s result %d", text, name(kCommands, e.a),
+                 (int)e.b);
+        break;
+    case flight::EV_NOTIFY:
+        snprintf(details, sizeof(details), "%s %s result %d", text, name(kNotifications, e.a),
+                 (int)e.b);
+        break;
+    case flight::EV_STATE:
+        snprintf(details, sizeof(details), "%s %s -> %s", text, name(kStates, e.a),
+                 name(kStates, e.b));
+        break;
+    case flight::EV_BUS_MESSAGE:
+        snprintf(details, sizeof(details), "%s %s", text, messageName(e.a).c_str());
+        break;
+    case flight::EV_BUFFERS:
+        snprintf(details, sizeof(details), "frames %" PRIu64 ", bytes %" PRIu64, e.a, e.b);
+        break;
+    case flight::EV_ERROR:
+        snprintf(details, sizeof(details), "%s code %" PRId64, text, (int64_t)e.a);
+        break;
+    case flight::EV_TIMEOUT:
+        snprintf(details, sizeof(details), "%s %s", text, name(kCommands, e.a));
+        break;
+    case flight::EV_SPAWN:
+        snprintf(details, sizeof(details), "%s pid %" PRIu64, text, e.a);
+        break;
+    case flight::EV_EXIT:
+        snprintf(details, sizeof(details), "pid %" PRIu64 " status 0x%" PRIx64, e.a, e.b);
+        break;
+    case flight::EV_SIGNAL:
+        snprintf(details, sizeof(details), "signal %" PRIu64, e.a);
+        break;
+    default:
+        snprintf(details, sizeof(details), "%s a %" PRIu64 " b %" PRIu64, text, e.a, e.b);
+        break;
+    }
+
+    printf("%s.%06" PRIu64 " %-20s %6u %-10s %s\n", clock, (realtime % 1000000000) / 1000,
+           e.process.c_str(), e.tid, name(kEvents, e.event), details);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s ring...\n"
+               "       rings are dumps in %s or live ones in /dev/shm\n",
+               argv[0], flight::kDumpDir);
+        return 1;
+    }
+
+    std::vector<entry_t> entries;
+    bool loaded = false;
+    for (int i = 1; i < argc; i++)
+        loaded = load(argv[i], entries) || loaded;
+    if (!loaded)
+        return 1;
+
+    // one monotonic clock for all processes, the sequence orders records of the same time
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const entry_t &l, const entry_t &r)
+                     { return l.time < r.time || (l.time == r.time && l.seq < r.seq); });
+
+    for (const auto &e : entries)
+        print(e);
+    return 0;
+}
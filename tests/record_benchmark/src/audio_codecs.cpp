@@ -0,0 +1,131 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "AudioCodecs"
+#include "audio_codecs.h"
+#include "json_utils.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// voice, the rate all codecs support
+static const unsigned int kSampleRate = 48000;
+static const unsigned int kChannels   = 1;
+
+// file format each codec is recorded to
+static const std::map<std::string, std::string> kFormats = {
+    {"AAC", "M4A"}, {"OPUS", "OGG"}, {"FLAC", "FLAC"}, {"PCM", "WAV"}};
+
+static nlohmann::json record(RecorderClient &client, const options_t &options,
+                             const std::string &codec)
+{
+    auto format = kFormats.find(codec);
+    if (format == kFormats.end())
+        return {{"error", "unknown codec"}};
+
+    std::string ext = format->second;
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::string path = options.outputDir + "bench-" + codec + "." + ext;
+    unlink(path.c_str());
+
+    json j = client.call("open", {{"audio", true}});
+    if (j.is_null())
+        return {{"error", "open"}};
+    int recorderId = get_optional<int>(j, "recorderId").value_or(0);
+
+    json result = {{"format", format->second}};
+    if (client.call("setAudioFormat", {{"recorderId", recorderId},
+                                       {"codec", codec},
+                                       {"sampleRate", kSampleRate},
+                                       {"channelCount", kChannels}})
+            .is_null() ||
+        client.call("setOutputFile", {{"recorderId", recorderId}, {"path", path}}).is_null() ||
+        client.call("setOutputFormat", {{"recorderId", recorderId}, {"format", format->second}})
+            .is_null() ||
+        client.call("start", {{"recorderId", recorderId}}).is_null())
+    {
+        result["error"] = "start";
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(options.duration));
+
+        // cpu time of the audio branch so far, before stop tears it down
+        j = client.call("getStatistics", {{"recorderId", recorderId}});
+        if (!j.is_null() && j["statistics"].contains("audio"))
+        {
+            const json &audio      = j["statistics"]["audio"];
+            result["encoder"]      = audio.value("encoder", "");
+            result["cpuPerMinute"] = audio.value("cpuPerMinute", 0.0) / 1000000; // ms
+        }
+        else
+        {
+            result["error"] = "getStatistics";
+        }
+
+        j                = client.call("stop", {{"recorderId", recorderId}});
+        std::string file = j.is_null() ? path : get_optional<std::string>(j, "path").value_or(path);
+
+        // the file is finalized shortly after stop replies
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        struct stat st;
+        if (stat(file.c_str(), &st) == 0)
+        {
+            result["bytes"]   = st.st_size;
+            result["bitrate"] = st.st_size * 8 / std::max(1u, options.duration);
+        }
+        unlink(file.c_str());
+    }
+
+    client.call("close", {{"recorderId", recorderId}});
+    return result;
+}
+
+json audio_codecs::compare(RecorderClient &client, const options_t &options)
+{
+    json result = json::object();
+    for (const auto &codec : options.audioCodecs)
+    {
+        PLOGI("%s", codec.c_str());
+        result[codec] = record(client, options, codec);
+    }
+    return result;
+}
+
+void audio_codecs::print(const json &result)
+{
+    printf("%-8s %-6s %-12s %14s %12s %10s\n", "codec", "format", "encoder", "cpu ms/minute",
+           "bytes", "kbit/s");
+    for (const auto &it : result.items())
+    {
+        const json &r = it.value();
+        if (r.contains("error"))
+        {
+            printf("%-8s failed at %s\n", it.key().c_str(),
+                   r["error"].get<std::string>().c_str());
+            continue;
+        }
+        printf("%-8s %-6s %-12s %14.1f %12" PRIu64 " %10.1f\n", it.key().c_str(),
+               r.value("format", "").c_str(), r.value("encoder", "").c_str(),
+               r.value("cpuPerMinute", 0.0), r.value("bytes", (uint64_t)0),
+               r.value("bitrate", 0.0) / 1000);
+    }
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef AUDIO_CODECS_H_
+#define AUDIO_CODECS_H_
+
+#include "options.h"
+#include "recorder_client.h"
+#include <nlohmann/json.hpp>
+
+/**
+ * Records the same audio with each codec in turn and compares the cpu time the
+ * pipeline spends per minute of audio, along with the size of the files.
+ */
+namespace audio_codecs
+{
+// {"<codec>": {"format", "encoder", "cpuPerMinute", "bytes", "bitrate"}}, a codec that
+// failed to record has "error" instead
+nlohmann::json compare(RecorderClient &client, const options_t &options);
+void print(const nlohmann::json &result);
+} // namespace audio_codecs
+
+#endif // AUDIO_CODECS_H_
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "EncoderRank"
+#include "encoder_rank.h"
+#include "encoder_ranking.h"
+#include "log.h"
+#include <cinttypes>
+#include <fstream>
+#include <gst/gst.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace nlohmann;
+
+// ~2 s of 48 kHz stereo
+static const int kBuffers          = 100;
+static const GstClockTime kTimeout = 5 * GST_SECOND;
+
+static int64_t processCpuTime()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// cpu us the encoder takes for the test audio, -1 if it failed
+static int64_t measureEncoder(const std::string &encoder)
+{
+    std::string desc = "audiotestsrc num-buffers=" + std::to_string(kBuffers) +
+                       " samplesperbuffer=1024 ! audio/x-raw, rate=48000, channels=2" +
+                       " ! audioconvert ! " + encoder + " ! fakesink";
+
+    GError *err          = nullptr;
+    GstElement *pipeline = gst_parse_launch(desc.c_str(), &err);
+    if (err)
+    {
+        PLOGW("%s : %s", encoder.c_str(), err->message);
+        g_error_free(err);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return -1;
+    }
+
+    int64_t start = processCpuTime();
+    int64_t cpu   = -1;
+    GstBus *bus   = gst_element_get_bus(pipeline);
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE)
+    {
+        GstMessage *msg = gst_bus_timed_pop_filtered(
+            bus, kTimeout, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        if (msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS)
+            cpu = processCpuTime() - start;
+        if (msg)
+            gst_message_unref(msg);
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(pipeline);
+    return cpu;
+}
+
+json encoder_rank::measure(const std::vector<std::string> &encoders)
+{
+    json result = json::object();
+    for (const auto &name : encoders)
+    {
+        GstElementFactory *factory = gst_element_factory_find(name.c_str());
+        if (factory == nullptr)
+        {
+            PLOGW("%s is not installed", name.c_str());
+            continue;
+        }
+        gst_object_unref(factory);
+
+        int64_t cpu = measureEncoder(name);
+        PLOGI("%s : %" PRId64 " us", name.c_str(), cpu);
+        if (cpu >= 0)
+            result[name] = cpu;
+    }
+    return result;
+}
+
+bool encoder_rank::save(const json &result)
+{
+    json ranking = json::object();
+    {
+        std::ifstream file(kEncoderRankingPath);
+        ranking = json::parse(file, nullptr, false);
+        if (ranking.is_discarded() || !ranking.is_object())
+            ranking = json::object();
+    }
+    ranking.update(result);
+
+    std::string dir = kEncoderRankingPath;
+    mkdir(dirname(&dir[0]), 0755);
+
+    // written aside and renamed, a pipeline may be reading it
+    std::string tmp = std::string(kEncoderRankingPath) + "." + std::to_string(getpid());
+    {
+        std::ofstream file(tmp);
+        file << ranking.dump(4) << std::endl;
+        if (!file)
+            return false;
+    }
+    return rename(tmp.c_str(), kEncoderRankingPath) == 0;
+}
+
+void encoder_rank::print(const json &result)
+{
+    printf("%-16s %12s\n", "encoder", "cpu us");
+    for (const auto &it : result.items())
+        printf("%-16s %12" PRId64 "\n", it.key().c_str(), it.value().get<int64_t>());
+}
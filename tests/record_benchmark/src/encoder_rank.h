@@ -0,0 +1,38 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ENCODER_RANK_H_
+#define ENCODER_RANK_H_
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * Encodes the same test audio with each encoder in turn, in this process and one at a time,
+ * and measures the cpu time each one takes. The result is merged into kEncoderRankingPath,
+ * where g-record-pipeline picks the cheapest of its candidates from.
+ * No camera nor service is needed.
+ */
+namespace encoder_rank
+{
+// {"<encoder>": <cpu us>}, an encoder that is missing or failed is left out
+nlohmann::json measure(const std::vector<std::string> &encoders);
+bool save(const nlohmann::json &result);
+void print(const nlohmann::json &result);
+} // namespace encoder_rank
+
+#endif // ENCODER_RANK_H_
@@ -0,0 +1,130 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "FakeCamera"
+#include "fake_camera.h"
+#include "json_utils.h"
+#include "log.h"
+#include <algorithm>
+#include <unistd.h>
+
+// Enough for a few frames of the largest format the benchmark is run with
+static const unsigned int kShmSize = 32 * 1024 * 1024;
+
+FakeCamera::FakeCamera(const std::vector<std::string> &ids, unsigned int width,
+                       unsigned int height, unsigned int fps)
+    : LS::Handle(LS::registerService("com.webos.service.camera2")), ids_(ids), width_(width),
+      height_(height), fps_(fps)
+{
+    PLOGI("%zu cameras %ux%u@%u", ids.size(), width, height, fps);
+
+    LS_CATEGORY_BEGIN(FakeCamera, "/")
+    LS_CATEGORY_METHOD(getFormat)
+    LS_CATEGORY_END;
+
+    context_ = g_main_context_new();
+    loop_    = g_main_loop_new(context_, false);
+    attachToLoop(loop_);
+}
+
+FakeCamera::~FakeCamera()
+{
+    PLOGI("");
+
+    for (auto pipeline : pipelines_)
+    {
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+    }
+
+    g_main_loop_quit(loop_);
+    if (loopThread_ && loopThread_->joinable())
+        loopThread_->join();
+    g_main_loop_unref(loop_);
+    g_main_context_unref(context_);
+
+    for (const auto &id : ids_)
+        unlink(("/tmp/" + id).c_str());
+}
+
+bool FakeCamera::start()
+{
+    for (const auto &id : ids_)
+    {
+        // A stale socket from a previous run would make shmsink fail to bind.
+        std::string socket = "/tmp/" + id;
+        unlink(socket.c_str());
+
+        // Same caps the record pipeline expects from the camera
+        std::string desc = "videotestsrc is-live=true pattern=ball ! video/x-raw, format=RGB16";
+        desc += ", width=" + std::to_string(width_) + ", height=" + std::to_string(height_) +
+                ", framerate=" + std::to_string(fps_) + "/1";
+        desc += " ! shmsink wait-for-connection=false sync=true socket-path=" + socket +
+                " shm-size=" + std::to_string(kShmSize);
+        PLOGI("%s", desc.c_str());
+
+        GError *err          = nullptr;
+        GstElement *pipeline = gst_parse_launch(desc.c_str(), &err);
+        if (err)
+        {
+            PLOGE("%s", err->message);
+            g_error_free(err);
+            if (pipeline)
+                gst_object_unref(pipeline);
+            return false;
+        }
+        pipelines_.push_back(pipeline);
+
+        if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+        {
+            PLOGE("Failed to start camera %s", id.c_str());
+            return false;
+        }
+    }
+
+    loopThread_ = std::make_unique<std::thread>(g_main_loop_run, loop_);
+    return true;
+}
+
+bool FakeCamera::getFormat(LSMessage &message)
+{
+    auto *payload = LSMessageGetPayload(&message);
+    PLOGI("payload %s", payload);
+
+    json resp;
+    json j = json::parse(payload, nullptr, false);
+    std::string id = j.is_discarded() ? "" : get_optional<std::string>(j, "id").value_or("");
+    if (std::find(ids_.begin(), ids_.end(), id) == ids_.end())
+    {
+        resp["returnValue"] = false;
+        resp["errorText"]   = "unknown camera";
+    }
+    else
+    {
+        json params;
+        params["width"]     = width_;
+        params["height"]    = height_;
+        params["fps"]       = fps_;
+        params["format"]    = "YUV";
+        resp["returnValue"] = true;
+        resp["params"]      = params;
+    }
+
+    LS::Message request(&message);
+    request.respond(to_string(resp).c_str());
+
+    return true;
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef FAKE_CAMERA_H_
+#define FAKE_CAMERA_H_
+
+#include "luna-service2/lunaservice.hpp"
+#include <glib.h>
+#include <gst/gst.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Stand-in for com.webos.service.camera2 and the cameras it serves.
+ * Answers getFormat and publishes videotestsrc frames on /tmp/<id>, the socket the
+ * record pipeline reads a camera from.
+ */
+class FakeCamera : public LS::Handle
+{
+    std::vector<std::string> ids_;
+    unsigned int width_;
+    unsigned int height_;
+    unsigned int fps_;
+
+    GMainContext *context_{nullptr};
+    GMainLoop *loop_{nullptr};
+    std::unique_ptr<std::thread> loopThread_;
+    std::vector<GstElement *> pipelines_;
+
+public:
+    FakeCamera(const std::vector<std::string> &ids, unsigned int width, unsigned int height,
+               unsigned int fps);
+    ~FakeCamera();
+
+    FakeCamera(FakeCamera const &)            = delete;
+    FakeCamera &operator=(FakeCamera const &) = delete;
+
+    bool start();
+    bool getFormat(LSMessage &message);
+};
+
+#endif // FAKE_CAMERA_H_
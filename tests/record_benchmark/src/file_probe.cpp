@@ -0,0 +1,98 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "file_probe.h"
+#include <cstdint>
+#include <fstream>
+
+namespace file_probe
+{
+
+// Walks the top level boxes of an MP4 and returns the end of the header of the box of the
+// given type, 0 if it is not there (yet).
+static uint64_t findBox(const std::string &path, const char *type, uint64_t &fileSize)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return 0;
+
+    fileSize        = file.tellg();
+    uint64_t offset = 0;
+    while (offset + 8 <= fileSize)
+    {
+        unsigned char header[16];
+        file.seekg(offset);
+        if (!file.read(reinterpret_cast<char *>(header), 8))
+            return 0;
+
+        uint64_t size = (uint64_t(header[0]) << 24) | (header[1] << 16) | (header[2] << 8) |
+                        header[3];
+        uint64_t headerSize = 8;
+        if (size == 1)
+        {
+            // 64 bit largesize follows the type
+            if (!file.read(reinterpret_cast<char *>(header + 8), 8))
+                return 0;
+            size = 0;
+            for (int i = 8; i < 16; i++)
+                size = (size << 8) | header[i];
+            headerSize = 16;
+        }
+
+        if (std::string(reinterpret_cast<char *>(header + 4), 4) == type)
+            return offset + headerSize;
+
+        // size 0 is "up to the end of the file", a box still being written
+        if (size < headerSize)
+            return 0;
+        offset += size;
+    }
+    return 0;
+}
+
+bool hasMediaData(const std::string &path)
+{
+    uint64_t fileSize = 0;
+    uint64_t data     = findBox(path, "mdat", fileSize);
+    return data > 0 && fileSize > data;
+}
+
+bool isFinalized(const std::string &path)
+{
+    uint64_t fileSize = 0;
+    return findBox(path, "moov", fileSize) > 0;
+}
+
+bool isCompleteJpeg(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    std::streamoff size = file.tellg();
+    if (size < 4)
+        return false;
+
+    unsigned char soi[2], eoi[2];
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(soi), 2);
+    file.seekg(size - 2);
+    file.read(reinterpret_cast<char *>(eoi), 2);
+
+    return file && soi[0] == 0xFF && soi[1] == 0xD8 && eoi[0] == 0xFF && eoi[1] == 0xD9;
+}
+
+} // namespace file_probe
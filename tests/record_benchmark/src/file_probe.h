@@ -0,0 +1,39 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef FILE_PROBE_H_
+#define FILE_PROBE_H_
+
+#include <string>
+
+/**
+ * Checks on what the recorder has put on disk so far.
+ */
+namespace file_probe
+{
+
+// An MP4 with media data written after the mdat header
+bool hasMediaData(const std::string &path);
+
+// An MP4 with its moov box written, i.e. playable
+bool isFinalized(const std::string &path);
+
+// A JPEG from the SOI to the EOI marker
+bool isCompleteJpeg(const std::string &path);
+
+} // namespace file_probe
+
+#endif // FILE_PROBE_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "latency_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+// nearest-rank percentile of sorted samples
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void LatencyStats::add(const std::string &metric, double ms)
+{
+    if (samples_.find(metric) == samples_.end())
+        order_.push_back(metric);
+    samples_[metric].push_back(ms);
+}
+
+void LatencyStats::merge(const LatencyStats &other)
+{
+    for (const auto &name : other.order_)
+    {
+        for (double ms : other.samples_.at(name))
+            add(name, ms);
+    }
+}
+
+nlohmann::json LatencyStats::summary() const
+{
+    nlohmann::json result = nlohmann::json::object();
+    for (const auto &it : samples_)
+    {
+        std::vector<double> sorted = it.second;
+        std::sort(sorted.begin(), sorted.end());
+
+        nlohmann::json metric;
+        metric["count"] = sorted.size();
+        metric["min"]   = sorted.front();
+        metric["mean"]  = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        metric["p50"]   = percentile(sorted, 50);
+        metric["p90"]   = percentile(sorted, 90);
+        metric["p99"]   = percentile(sorted, 99);
+        metric["max"]   = sorted.back();
+        result[it.first] = metric;
+    }
+    return result;
+}
+
+void LatencyStats::print(const nlohmann::json &baseline) const
+{
+    nlohmann::json result = summary();
+
+    printf("%-24s %6s %9s %9s %9s %9s %9s %9s\n", "metric (ms)", "count", "min", "mean", "p50",
+           "p90", "p99", "max");
+    for (const auto &name : order_)
+    {
+        const nlohmann::json &m = result[name];
+        printf("%-24s %6zu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name.c_str(),
+               m["count"].get<size_t>(), m["min"].get<double>(), m["mean"].get<double>(),
+               m["p50"].get<double>(), m["p90"].get<double>(), m["p99"].get<double>(),
+               m["max"].get<double>());
+
+        if (!baseline.contains(name))
+            continue;
+
+        const nlohmann::json &b = baseline[name];
+        double p50              = b.value("p50", 0.0);
+        double p90              = b.value("p90", 0.0);
+        if (p50 > 0 && p90 > 0)
+        {
+            printf("%-24s %6s %9s %9s %+8.1f%% %+8.1f%%\n", "  vs baseline", "", "", "",
+                   (m["p50"].get<double>() - p50) * 100 / p50,
+                   (m["p90"].get<double>() - p90) * 100 / p90);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef LATENCY_STATS_H_
+#define LATENCY_STATS_H_
+
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * Latency samples per metric, summarized as a distribution.
+ * Results are kept as json so a release can be compared to the one before it.
+ */
+class LatencyStats
+{
+    std::vector<std::string> order_;
+    std::map<std::string, std::vector<double>> samples_; // ms
+
+public:
+    void add(const std::string &metric, double ms);
+    void merge(const LatencyStats &other);
+
+    // {"<metric>": {"count", "min", "mean", "p50", "p90", "p99", "max"}}
+    nlohmann::json summary() const;
+
+    // Prints the summary, with the change of p50/p90 against the baseline when given.
+    void print(const nlohmann::json &baseline) const;
+};
+
+#endif // LATENCY_STATS_H_
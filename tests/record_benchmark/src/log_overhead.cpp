@@ -0,0 +1,105 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "LogOverhead"
+#include "log_overhead.h"
+#include "flight_recorder.h"
+#include "json_utils.h"
+#include "log.h"
+#include <chrono>
+#include <functional>
+
+using Clock = std::chrono::steady_clock;
+
+// status as a recorder logs it, the argument evaluation the macros skip
+static const json kStatus = {{"duration", 1234567890}, {"bytes", 987654321},
+                             {"bitrate", 4000000},     {"fps", 29.97},
+                             {"frames", 37012},        {"dropped", 3}};
+
+static double nsPerCall(unsigned int iterations, const std::function<void()> &call)
+{
+    auto begin = Clock::now();
+    for (unsigned int i = 0; i < iterations; i++)
+        call();
+    return std::chrono::duration<double, std::nano>(Clock::now() - begin).count() /
+           std::max(1u, iterations);
+}
+
+json log_overhead::measure(unsigned int iterations)
+{
+    PmLogContext context = getRecorderLunaPmLogContext();
+    int level            = kPmLogLevel_Info;
+    PmLogGetContextLevel(context, &level);
+
+    json result = json::object();
+
+    // info disabled
+    PmLogSetContextLevel(context, kPmLogLevel_Warning);
+    result["unguarded"] = {
+        {"nsPerCall", nsPerCall(iterations,
+                                []()
+                                {
+                                    PLOGI_("status : %s", to_string(kStatus).c_str());
+                                })},
+        {"note", "PmLogInfo with its arguments evaluated, as PLOGI used to expand"}};
+    result["PLOGI"] = {
+        {"nsPerCall",
+         nsPerCall(iterations, []() { PLOGI("status : %s", to_string(kStatus).c_str()); })},
+        {"note", "info disabled at run time"}};
+    result["PLOGD"] = {
+        {"nsPerCall",
+         nsPerCall(iterations, []() { PLOGD("status : %s", to_string(kStatus).c_str()); })},
+        {"note", (kPmLogLevel_Debug <= PLOG_MIN_LEVEL) ? "debug disabled at run time"
+                                                       : "debug compiled out"}};
+
+    // info enabled, all but one call a second suppressed
+    PmLogSetContextLevel(context, kPmLogLevel_Info);
+    result["PLOGI_EVERY_MS"] = {
+        {"nsPerCall", nsPerCall(iterations,
+                                []()
+                                {
+                                    PLOGI_EVERY_MS(1000, "status : %s",
+                                                   to_string(kStatus).c_str());
+                                })},
+        {"note", "info enabled, one call a second logged"}};
+
+    PmLogSetContextLevel(context, level);
+
+    // always on, the budget is about 50 ns per event
+    if (flight::open("benchmark"))
+    {
+        result["flight::record"] = {
+            {"nsPerCall", nsPerCall(iterations,
+                                    []()
+                                    {
+                                        flight::record(flight::EV_BUS_MESSAGE, 1, 0,
+                                                       "videoEncoder");
+                                    })},
+            {"note", "flight recorder event"}};
+        flight::close();
+    }
+    return result;
+}
+
+void log_overhead::print(const json &result)
+{
+    printf("%-16s %12s\n", "variant", "ns/call");
+    for (const auto &it : result.items())
+    {
+        printf("%-16s %12.1f  %s\n", it.key().c_str(), it.value().value("nsPerCall", 0.0),
+               it.value().value("note", "").c_str());
+    }
+}
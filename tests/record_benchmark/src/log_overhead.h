@@ -0,0 +1,34 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef LOG_OVERHEAD_H_
+#define LOG_OVERHEAD_H_
+
+#include <nlohmann/json.hpp>
+
+/**
+ * Cost per call of the log macros of log.h at a level that is not logged, next to the
+ * unguarded PmLog call they used to expand to, and of a flight recorder event.
+ * No camera nor service is needed.
+ */
+namespace log_overhead
+{
+// {"<variant>": {"nsPerCall", "note"}}
+nlohmann::json measure(unsigned int iterations);
+void print(const nlohmann::json &result);
+} // namespace log_overhead
+
+#endif // LOG_OVERHEAD_H_
@@ -0,0 +1,381 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#define LOG_TAG "RecordBenchmark"
+#include "audio_codecs.h"
+#include "encoder_rank.h"
+#include "fake_camera.h"
+#include "file_probe.h"
+#include "json_utils.h"
+#include "latency_stats.h"
+#include "log.h"
+#include "log_overhead.h"
+#include "options.h"
+#include "recorder_client.h"
+#include "scaling_soak.h"
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+// interval the output files are polled at
+static const auto kPollInterval = std::chrono::milliseconds(2);
+// longest wait for a file to reach the expected state
+static const auto kFileTimeout = std::chrono::seconds(10);
+
+static double elapsedMs(Clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+static bool waitFor(const std::function<bool()> &condition)
+{
+    auto deadline = Clock::now() + kFileTimeout;
+    while (!condition())
+    {
+        if (Clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(kPollInterval);
+    }
+    return true;
+}
+
+// One open -> start -> takeSnapshot -> stop -> close cycle
+static bool runIteration(RecorderClient &client, const options_t &options, unsigned int index,
+                         LatencyStats &stats)
+{
+    std::string path = options.outputDir + "bench-" + std::to_string(index) + ".mp4";
+    unlink(path.c_str());
+
+    auto begin = Clock::now();
+    json j     = client.call("open", {{"video", options.camera}});
+    if (j.is_null())
+        return false;
+    stats.add("open", elapsedMs(begin));
+    int recorderId = get_optional<int>(j, "recorderId").value_or(0);
+
+    if (client.call("setOutputFile", {{"recorderId", recorderId}, {"path", path}}).is_null() ||
+        client.call("setOutputFormat", {{"recorderId", recorderId}, {"format", "MP4"}}).is_null())
+    {
+        client.call("close", {{"recorderId", recorderId}});
+        return false;
+    }
+
+    bool result = false;
+    auto start  = Clock::now();
+    if (!client.call("start", {{"recorderId", recorderId}}).is_null())
+    {
+        stats.add("start", elapsedMs(start));
+        if (waitFor([&path]() { return file_probe::hasMediaData(path); }))
+        {
+            stats.add("start to first frame", elapsedMs(start));
+            stats.add("open to first frame", elapsedMs(begin));
+        }
+
+        // snapshot in the middle of the recording
+        std::this_thread::sleep_for(std::chrono::seconds(options.duration) / 2);
+        auto snapshot = Clock::now();
+        j             = client.call("takeSnapshot",
+                             {{"recorderId", recorderId},
+                              {"path", options.outputDir},
+                              {"format", "JPEG"}});
+        std::string jpeg = get_optional<std::string>(j, "path").value_or("");
+        if (!jpeg.empty() && waitFor([&jpeg]() { return file_probe::isCompleteJpeg(jpeg); }))
+            stats.add("snapshot to jpeg", elapsedMs(snapshot));
+        unlink(jpeg.c_str());
+
+        std::this_thread::sleep_for(std::chrono::seconds(options.duration) / 2);
+        auto stop = Clock::now();
+        j         = client.call("stop", {{"recorderId", recorderId}});
+        if (!j.is_null())
+        {
+            stats.add("stop", elapsedMs(stop));
+            std::string file = get_optional<std::string>(j, "path").value_or(path);
+            result = waitFor([&file]() { return file_probe::isFinalized(file); });
+            if (result)
+                stats.add("stop to finalized", elapsedMs(stop));
+            unlink(file.c_str());
+        }
+    }
+
+    auto close = Clock::now();
+    if (!client.call("close", {{"recorderId", recorderId}}).is_null())
+        stats.add("close", elapsedMs(close));
+
+    return result;
+}
+
+// Latency distribution of the API, one recorder at a time
+static int runLatency(const options_t &options)
+{
+    json baseline = json::object();
+    if (!options.baselineFile.empty())
+    {
+        std::ifstream file(options.baselineFile);
+        baseline = json::parse(file, nullptr, false);
+        if (baseline.is_discarded() || !baseline.contains("metrics"))
+        {
+            printf("Invalid baseline %s\n", options.baselineFile.c_str());
+            return 1;
+        }
+        baseline = baseline["metrics"];
+    }
+
+    RecorderClient client("com.webos.service.mediarecorder.benchmark");
+    LatencyStats stats;
+    unsigned int failed = 0;
+    for (unsigned int i = 0; i < options.iterations; i++)
+    {
+        if (!runIteration(client, options, i, stats))
+            failed++;
+    }
+
+    printf("%s %ux%u@%u, %u iterations, %u failed\n", options.camera.c_str(), options.width,
+           options.height, options.fps, options.iterations, failed);
+    stats.print(baseline);
+
+    if (!options.resultFile.empty())
+    {
+        json result;
+        result["camera"]     = {{"width", options.width},
+                                {"height", options.height},
+                                {"fps", options.fps}};
+        result["iterations"] = options.iterations;
+        result["failed"]     = failed;
+        result["metrics"]    = stats.summary();
+
+        std::ofstream file(options.resultFile);
+        file << result.dump(4) << std::endl;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+// Scaling from 1 to options.recorders concurrent recorders
+static int runScaling(const options_t &options)
+{
+    ScalingSoak soak(options);
+    unsigned int knee = 0;
+    std::string reason;
+    std::vector<ScalingSoak::step_t> steps = soak.run(knee, reason);
+
+    if (knee == 0)
+        printf("no knee up to %u recorders\n", options.recorders);
+
+    if (!options.resultFile.empty())
+    {
+        json result        = ScalingSoak::toJson(steps, knee, reason);
+        result["camera"]   = {{"width", options.width},
+                              {"height", options.height},
+                              {"fps", options.fps},
+                              {"cameras", options.cameras}};
+        result["stepTime"] = options.stepTime;
+
+        std::ofstream file(options.resultFile);
+        file << result.dump(4) << std::endl;
+    }
+
+    return 0;
+}
+
+// CPU per minute of audio of each codec
+static int runAudioCodecs(const options_t &options)
+{
+    RecorderClient client("com.webos.service.mediarecorder.benchmark");
+    json result = audio_codecs::compare(client, options);
+    audio_codecs::print(result);
+
+    if (!options.resultFile.empty())
+    {
+        json j;
+        j["duration"] = options.duration;
+        j["codecs"]   = result;
+
+        std::ofstream file(options.resultFile);
+        file << j.dump(4) << std::endl;
+    }
+
+    for (const auto &it : result)
+    {
+        if (it.contains("error"))
+            return 1;
+    }
+    return 0;
+}
+
+// CPU time of each audio encoder, saved for g-record-pipeline
+static int runEncoderRank(const options_t &options)
+{
+    json result = encoder_rank::measure(options.audioEncoders);
+    encoder_rank::print(result);
+
+    if (!options.resultFile.empty())
+    {
+        std::ofstream file(options.resultFile);
+        file << result.dump(4) << std::endl;
+    }
+
+    if (result.empty() || !encoder_rank::save(result))
+    {
+        printf("No ranking saved\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Cost of the log macros with logging disabled
+static int runLogOverhead(const options_t &options)
+{
+    json result = log_overhead::measure(options.logCalls);
+    log_overhead::print(result);
+
+    if (!options.resultFile.empty())
+    {
+        json j;
+        j["calls"]    = options.logCalls;
+        j["variants"] = result;
+
+        std::ofstream file(options.resultFile);
+        file << j.dump(4) << std::endl;
+    }
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-n iterations] [-c camera id] [-w width] [-h height] [-f fps]\n"
+           "          [-d seconds per recording] [-o output dir] [-r result.json]\n"
+           "          [-b baseline.json]\n"
+           "       %s -s max recorders [-t seconds per step] [-m cameras] [-c camera id]\n"
+           "          [-w width] [-h height] [-f fps] [-d seconds per recording]\n"
+           "          [-o output dir] [-r result.json]\n"
+           "       %s -a codec,... [-d seconds per codec] [-o output dir] [-r result.json]\n"
+           "       %s -e encoder,... [-r result.json]\n"
+           "       %s -l calls per variant [-r result.json]\n",
+           name, name, name, name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    options_t options;
+    int c;
+    while ((c = getopt(argc, argv, "n:c:m:w:h:f:d:s:t:a:e:l:o:r:b:")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            options.iterations = std::stoul(optarg);
+            break;
+        case 'c':
+            options.camera = optarg;
+            break;
+        case 'm':
+            options.cameras = std::max(1ul, std::stoul(optarg));
+            break;
+        case 'w':
+            options.width = std::stoul(optarg);
+            break;
+        case 'h':
+            options.height = std::stoul(optarg);
+            break;
+        case 'f':
+            options.fps = std::stoul(optarg);
+            break;
+        case 'd':
+            options.duration = std::stoul(optarg);
+            break;
+        case 's':
+            options.recorders = std::stoul(optarg);
+            break;
+        case 't':
+            options.stepTime = std::stoul(optarg);
+            break;
+        case 'a':
+        {
+            std::stringstream codecs(optarg);
+            std::string codec;
+            while (std::getline(codecs, codec, ','))
+                options.audioCodecs.push_back(codec);
+            break;
+        }
+        case 'e':
+        {
+            std::stringstream encoders(optarg);
+            std::string encoder;
+            while (std::getline(encoders, encoder, ','))
+                options.audioEncoders.push_back(encoder);
+            break;
+        }
+        case 'l':
+            options.logCalls = std::stoul(optarg);
+            break;
+        case 'o':
+            options.outputDir = optarg;
+            if (options.outputDir.back() != '/')
+                options.outputDir += "/";
+            break;
+        case 'r':
+            options.resultFile = optarg;
+            break;
+        case 'b':
+            options.baselineFile = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // no gstreamer, camera nor service needed
+    if (options.logCalls > 0)
+        return runLogOverhead(options);
+
+    gst_init(&argc, &argv);
+
+    // in this process only, no service needed
+    if (!options.audioEncoders.empty())
+        return runEncoderRank(options);
+
+    mkdir(options.outputDir.c_str(), 0755);
+
+    // audio only, no camera needed
+    if (!options.audioCodecs.empty())
+        return runAudioCodecs(options);
+
+    // <camera>, <camera>-2, ...
+    std::vector<std::string> cameras{options.camera};
+    for (unsigned int i = 2; i <= options.cameras; i++)
+        cameras.push_back(options.camera + "-" + std::to_string(i));
+
+    try
+    {
+        FakeCamera camera(cameras, options.width, options.height, options.fps);
+        if (!camera.start())
+            return 1;
+
+        return (options.recorders > 0) ? runScaling(options) : runLatency(options);
+    }
+    catch (LS::Error &err)
+    {
+        LSErrorPrint(err, stdout);
+        return 1;
+    }
+}
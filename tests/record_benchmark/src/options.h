@@ -0,0 +1,41 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OPTIONS_H_
+#define OPTIONS_H_
+
+#include <string>
+#include <vector>
+
+struct options_t
+{
+    unsigned int iterations = 20;
+    std::string camera      = "camera1";
+    unsigned int cameras    = 1; // synthetic cameras, <camera>, <camera>-2, ...
+    unsigned int width      = 1280;
+    unsigned int height     = 720;
+    unsigned int fps        = 30;
+    unsigned int duration   = 2;  // s recorded per cycle
+    unsigned int recorders  = 0;  // ramp up to this many concurrent recorders, 0 : latency only
+    unsigned int stepTime   = 30; // s each step of the ramp is held
+    std::string outputDir   = "/tmp/record_benchmark/";
+    std::string resultFile;
+    std::string baselineFile;
+    std::vector<std::string> audioCodecs;   // codecs to compare, none : latency only
+    std::vector<std::string> audioEncoders; // encoders to rank, none : no ranking run
+    unsigned int logCalls = 0;            // calls per log variant, 0 : no log overhead run
+};
+
+#endif // OPTIONS_H_
@@ -0,0 +1,78 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "process_stats.h"
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+
+namespace process_stats
+{
+
+static const char *const kProcessNames[] = {"com.webos.service.mediarecorder",
+                                            "g-record-pipeline"};
+
+static bool isRecorderProcess(const std::string &pid)
+{
+    // argv[0] up to the first NUL
+    std::ifstream cmdline("/proc/" + pid + "/cmdline");
+    std::string exe;
+    if (!std::getline(cmdline, exe, '\0'))
+        return false;
+
+    std::string name = exe.substr(exe.find_last_of('/') + 1);
+    for (const char *process : kProcessNames)
+    {
+        if (name == process)
+            return true;
+    }
+    return false;
+}
+
+usage_t sample()
+{
+    usage_t usage;
+
+    DIR *proc = opendir("/proc");
+    if (proc == nullptr)
+        return usage;
+
+    while (struct dirent *entry = readdir(proc))
+    {
+        std::string pid = entry->d_name;
+        if (pid.find_first_not_of("0123456789") != std::string::npos || !isRecorderProcess(pid))
+            continue;
+
+        std::ifstream status("/proc/" + pid + "/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            std::istringstream fields(line);
+            std::string key;
+            uint64_t value = 0;
+            fields >> key >> value;
+            if (key == "VmRSS:")
+                usage.rss += value;
+            else if (key == "Threads:")
+                usage.threads += value;
+        }
+        usage.processes++;
+    }
+    closedir(proc);
+
+    return usage;
+}
+
+} // namespace process_stats
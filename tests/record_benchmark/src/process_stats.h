@@ -0,0 +1,39 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef PROCESS_STATS_H_
+#define PROCESS_STATS_H_
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Resource usage of the recorder service and its g-record-pipeline processes, from /proc.
+ */
+namespace process_stats
+{
+
+struct usage_t
+{
+    uint32_t processes{0};
+    uint64_t rss{0}; // kB
+    uint64_t threads{0};
+};
+
+usage_t sample();
+
+} // namespace process_stats
+
+#endif // PROCESS_STATS_H_
@@ -0,0 +1,60 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#define LOG_TAG "RecorderClient"
+#include "recorder_client.h"
+#include "json_utils.h"
+#include "log.h"
+
+static const char *const kRecorderUri = "luna://com.webos.service.mediarecorder/";
+// stop waits for the file to be finalized
+static const int kCallTimeout = 16000;
+
+RecorderClient::RecorderClient(const std::string &name)
+{
+    GMainContext *c = g_main_context_new();
+    loop_           = g_main_loop_new(c, false);
+    lunaClient_     = std::make_unique<LunaClient>(name.c_str(), c);
+    g_main_context_unref(c);
+
+    loopThread_ = std::make_unique<std::thread>(g_main_loop_run, loop_);
+    while (!g_main_loop_is_running(loop_))
+        std::this_thread::yield();
+}
+
+RecorderClient::~RecorderClient()
+{
+    g_main_loop_quit(loop_);
+    if (loopThread_->joinable())
+        loopThread_->join();
+
+    lunaClient_.reset();
+    g_main_loop_unref(loop_);
+}
+
+json RecorderClient::call(const std::string &method, const json &param)
+{
+    std::string uri = kRecorderUri + method;
+    std::string resp;
+    lunaClient_->callSync(uri.c_str(), to_string(param).c_str(), &resp, kCallTimeout);
+
+    json j = json::parse(resp, nullptr, false);
+    if (j.is_discarded() || !get_optional<bool>(j, "returnValue").value_or(false))
+    {
+        PLOGE("%s failed : %s", method.c_str(), resp.c_str());
+        return json();
+    }
+    return j;
+}
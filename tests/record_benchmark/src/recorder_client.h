@@ -0,0 +1,47 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef RECORDER_CLIENT_H_
+#define RECORDER_CLIENT_H_
+
+#include "luna_client.h"
+#include <glib.h>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+
+/**
+ * Luna client of com.webos.service.mediarecorder with a main loop of its own,
+ * so several of them can call the service from different threads at once.
+ */
+class RecorderClient
+{
+    GMainLoop *loop_{nullptr};
+    std::unique_ptr<std::thread> loopThread_;
+    std::unique_ptr<LunaClient> lunaClient_;
+
+public:
+    explicit RecorderClient(const std::string &name);
+    ~RecorderClient();
+
+    RecorderClient(RecorderClient const &)            = delete;
+    RecorderClient &operator=(RecorderClient const &) = delete;
+
+    // Returns the reply, null if the call failed or returned an error.
+    nlohmann::json call(const std::string &method, const nlohmann::json &param);
+};
+
+#endif // RECORDER_CLIENT_H_
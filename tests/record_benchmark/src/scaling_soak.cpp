@@ -0,0 +1,268 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#define LOG_TAG "ScalingSoak"
+#include "scaling_soak.h"
+#include "file_probe.h"
+#include "json_utils.h"
+#include "log.h"
+#include <cinttypes>
+#include <thread>
+#include <unistd.h>
+
+// interval of the resource usage samples
+static const auto kSampleInterval = std::chrono::seconds(1);
+// pause after a failed cycle, so a broken service is not hammered
+static const auto kRetryDelay = std::chrono::milliseconds(500);
+// interval between snapshots of a snapshotter
+static const auto kSnapshotInterval = std::chrono::milliseconds(500);
+
+// Knee criteria, against the single recorder step
+// throughput per recorder below this share of the single recorder one
+static const double kMinEfficiency = 0.8;
+// p99 of an API above this multiple of the single recorder one
+static const double kMaxLatencyGrowth = 3.0;
+// dropped share of the encoded frames
+static const double kMaxDropRatio = 0.01;
+
+ScalingSoak::ScalingSoak(const options_t &options) : options_(options)
+{
+    for (unsigned int i = 0; i < options.recorders; i++)
+    {
+        clients_.push_back(std::make_unique<RecorderClient>(
+            "com.webos.service.mediarecorder.benchmark-" + std::to_string(i)));
+    }
+}
+
+std::vector<ScalingSoak::step_t> ScalingSoak::run(unsigned int &knee, std::string &reason)
+{
+    std::vector<step_t> steps;
+    knee = 0;
+    for (unsigned int recorders = 1; recorders <= options_.recorders; recorders++)
+    {
+        steps.push_back(runStep(recorders));
+
+        const step_t &step = steps.back();
+        printf("%u recorders : %.2f cycles/s, %.2f snapshots/s, %" PRIu64 " errors, %" PRIu64
+               " collisions, %u processes, %" PRIu64 " kB, %" PRIu64 " threads, %" PRIu64
+               "/%" PRIu64 " dropped\n",
+               recorders, step.cycles / step.seconds, step.snapshots / step.seconds, step.errors,
+               step.collisions, step.peak.processes, step.peak.rss, step.peak.threads,
+               step.dropped, step.frames);
+
+        if (knee == 0 && isKnee(steps.front(), step, reason))
+        {
+            knee = recorders;
+            printf("knee at %u recorders : %s\n", recorders, reason.c_str());
+        }
+    }
+    return steps;
+}
+
+ScalingSoak::step_t ScalingSoak::runStep(unsigned int recorders)
+{
+    step_t result;
+    result.recorders = recorders;
+
+    auto begin    = Clock::now();
+    auto deadline = begin + std::chrono::seconds(options_.stepTime);
+
+    std::vector<step_t> results(recorders);
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < recorders; i++)
+        workers.emplace_back(&ScalingSoak::worker, this, i, deadline, std::ref(results[i]));
+
+    while (Clock::now() < deadline)
+    {
+        process_stats::usage_t usage = process_stats::sample();
+        result.peak.processes        = std::max(result.peak.processes, usage.processes);
+        result.peak.rss              = std::max(result.peak.rss, usage.rss);
+        result.peak.threads          = std::max(result.peak.threads, usage.threads);
+        std::this_thread::sleep_for(kSampleInterval);
+    }
+
+    for (auto &worker : workers)
+        worker.join();
+    result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    for (const auto &it : results)
+    {
+        result.cycles += it.cycles;
+        result.snapshots += it.snapshots;
+        result.errors += it.errors;
+        result.collisions += it.collisions;
+        result.frames += it.frames;
+        result.dropped += it.dropped;
+        result.latency.merge(it.latency);
+    }
+    return result;
+}
+
+void ScalingSoak::worker(unsigned int index, Clock::time_point deadline, step_t &result)
+{
+    while (Clock::now() < deadline)
+    {
+        if (!cycle(index, deadline, result))
+            std::this_thread::sleep_for(kRetryDelay);
+    }
+}
+
+bool ScalingSoak::cycle(unsigned int index, Clock::time_point deadline, step_t &result)
+{
+    RecorderClient &client = *clients_[index];
+    auto timed             = [&client, &result](const std::string &method, const json &param)
+    {
+        auto begin = Clock::now();
+        json j     = client.call(method, param);
+        if (j.is_null())
+            result.errors++;
+        else
+            result.latency.add(
+                method, std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+        return j;
+    };
+
+    std::string camera = options_.camera;
+    if (index % options_.cameras > 0)
+        camera += "-" + std::to_string(index % options_.cameras + 1);
+
+    json j = timed("open", {{"video", camera}});
+    if (j.is_null())
+        return false;
+
+    int recorderId = get_optional<int>(j, "recorderId").value_or(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!openIds_.insert(recorderId).second)
+            result.collisions++;
+    }
+
+    std::string path = options_.outputDir + "soak-" + std::to_string(index) + ".mp4";
+    bool ok = !timed("setOutputFile", {{"recorderId", recorderId}, {"path", path}}).is_null() &&
+              !timed("setOutputFormat", {{"recorderId", recorderId}, {"format", "MP4"}})
+                   .is_null() &&
+              !timed("start", {{"recorderId", recorderId}}).is_null();
+
+    if (ok)
+    {
+        // Recording ends with the step at the latest, so every step starts from idle.
+        auto end = std::min(deadline, Clock::now() + std::chrono::seconds(options_.duration));
+        while (Clock::now() < end)
+        {
+            if (index % 2 == 0)
+            {
+                std::this_thread::sleep_until(end);
+                break;
+            }
+
+            j = timed("takeSnapshot", {{"recorderId", recorderId},
+                                       {"path", options_.outputDir},
+                                       {"format", "JPEG"}});
+            std::string jpeg = get_optional<std::string>(j, "path").value_or("");
+            if (!jpeg.empty() && file_probe::isCompleteJpeg(jpeg))
+                result.snapshots++;
+            unlink(jpeg.c_str());
+            std::this_thread::sleep_for(kSnapshotInterval);
+        }
+
+        j = timed("getRecordingStatus", {{"recorderId", recorderId}});
+        if (j.contains("recordingStatus"))
+        {
+            result.frames += get_optional<uint64_t>(j["recordingStatus"], "frames").value_or(0);
+            result.dropped += get_optional<uint64_t>(j["recordingStatus"], "dropped").value_or(0);
+        }
+
+        ok = !timed("stop", {{"recorderId", recorderId}}).is_null();
+        unlink(path.c_str());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        openIds_.erase(recorderId);
+    }
+    ok = !timed("close", {{"recorderId", recorderId}}).is_null() && ok;
+    if (ok)
+        result.cycles++;
+
+    return ok;
+}
+
+bool ScalingSoak::isKnee(const step_t &first, const step_t &step, std::string &reason)
+{
+    if (step.errors > 0 || step.collisions > 0)
+    {
+        reason = "failed calls";
+        return true;
+    }
+
+    if (step.frames > 0 && step.dropped > step.frames * kMaxDropRatio)
+    {
+        reason = "dropped frames";
+        return true;
+    }
+
+    double base = first.cycles / first.seconds;
+    if (base > 0 && step.cycles / step.seconds < base * step.recorders * kMinEfficiency)
+    {
+        reason = "throughput";
+        return true;
+    }
+
+    json firstLatency = first.latency.summary();
+    json latency      = step.latency.summary();
+    for (const auto &it : latency.items())
+    {
+        if (!firstLatency.contains(it.key()))
+            continue;
+
+        double p99 = firstLatency[it.key()]["p99"].get<double>();
+        if (p99 > 0 && it.value()["p99"].get<double>() > p99 * kMaxLatencyGrowth)
+        {
+            reason = it.key() + " p99 latency";
+            return true;
+        }
+    }
+
+    return false;
+}
+
+json ScalingSoak::toJson(const std::vector<step_t> &steps, unsigned int knee,
+                         const std::string &reason)
+{
+    json result;
+    result["steps"] = json::array();
+    for (const auto &step : steps)
+    {
+        json j;
+        j["recorders"]  = step.recorders;
+        j["seconds"]    = step.seconds;
+        j["cycles"]     = step.cycles;
+        j["snapshots"]  = step.snapshots;
+        j["errors"]     = step.errors;
+        j["collisions"] = step.collisions;
+        j["frames"]     = step.frames;
+        j["dropped"]    = step.dropped;
+        j["processes"]  = step.peak.processes;
+        j["rss"]        = step.peak.rss;
+        j["threads"]    = step.peak.threads;
+        j["latency"]    = step.latency.summary();
+        result["steps"].push_back(j);
+    }
+
+    if (knee > 0)
+        result["knee"] = {{"recorders", knee}, {"reason", reason}};
+
+    return result;
+}
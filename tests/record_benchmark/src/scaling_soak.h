@@ -0,0 +1,76 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef SCALING_SOAK_H_
+#define SCALING_SOAK_H_
+
+#include "latency_stats.h"
+#include "options.h"
+#include "process_stats.h"
+#include "recorder_client.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+/**
+ * Ramps from 1 to N concurrent recorders and holds each step for a while.
+ * Odd workers take snapshots while recording, even ones only record. Every step
+ * reports throughput, API tail latency, RSS, threads and dropped frames, and the
+ * first step that no longer scales is reported as the knee.
+ */
+class ScalingSoak
+{
+public:
+    struct step_t
+    {
+        unsigned int recorders{0};
+        double seconds{0};
+        uint64_t cycles{0};     // open to close cycles completed
+        uint64_t snapshots{0};  // snapshots on disk
+        uint64_t errors{0};     // failed calls
+        uint64_t collisions{0}; // recorderId given to two open recorders at once
+        uint64_t frames{0};     // encoded frames reported by the recorders
+        uint64_t dropped{0};    // frames dropped as reported by the recorders
+        process_stats::usage_t peak;
+        LatencyStats latency;
+    };
+
+    explicit ScalingSoak(const options_t &options);
+
+    // Returns the steps run. knee is the number of recorders of the first step that did not
+    // scale, 0 if all of them did.
+    std::vector<step_t> run(unsigned int &knee, std::string &reason);
+    static nlohmann::json toJson(const std::vector<step_t> &steps, unsigned int knee,
+                                 const std::string &reason);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const options_t &options_;
+    std::vector<std::unique_ptr<RecorderClient>> clients_;
+
+    std::mutex mutex_;
+    std::set<int> openIds_;
+
+    step_t runStep(unsigned int recorders);
+    void worker(unsigned int index, Clock::time_point deadline, step_t &result);
+    bool cycle(unsigned int index, Clock::time_point deadline, step_t &result);
+    static bool isKnee(const step_t &first, const step_t &step, std::string &reason);
+};
+
+#endif // SCALING_SOAK_H_